@@ -0,0 +1,248 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "Matrix.cpp"
+#include "Flux.h"
+
+/*
+      .
+
+        -   :
+    eta_k^2 -     (s* - s_h)^2 / lambda,  s_h = -lambda u_h' - 
+    ,  s* -  .   s*   nodal_flux,  
+        s' = f - gamma u_h      ,
+        .      ,
+        .      , 
+         ,    .
+     eta_k^2      .
+
+        ,  ,   ĸ 
+       ,      theta
+     ,         .
+     ,     tolerance,   
+       max_dofs    max_steps .
+*/
+template<typename T>
+struct AdaptiveOptions
+{
+    //      
+    T tolerance = 1e-6;
+    //   
+    int max_dofs = 1000000;
+    //    ,    
+    T theta = 0.5;
+    int max_steps = 50;
+};
+
+template<typename T>
+struct AdaptiveResult
+{
+    int steps = 0, dofs = 0;
+    //        
+    T estimate = 0;
+};
+
+//    eta     q  P.
+template<typename T, int P>
+void recovery_indicator(grid_in& in, const std::vector<T>& q, IInputFunctions<T>& Functions, std::vector<T>& eta)
+{
+    const int N = P + 1;
+    const int Q = P + 2;
+    //  : Q     Q    [x_k, x_g]   
+    const int M = Q * (Q + 1);
+    const int batch = 64;
+
+    std::vector<T> flux;
+    nodal_flux(in, q, Functions, flux);
+
+    double t[Q], w[Q];
+    gauss_legendre(Q, t, w);
+    //        t[g]  t[g] * t[j]
+    std::array<std::array<T, M>, N> phi;
+    std::array<std::array<T, Q>, N> dphi;
+    for (int i = 0; i < N; i++)
+        for (int g = 0; g < Q; g++)
+        {
+            phi[i][g] = (T)lagrange(P, i, t[g]);
+            dphi[i][g] = (T)lagrange_derivative(P, i, t[g]);
+            for (int j = 0; j < Q; j++)
+                phi[i][Q + g * Q + j] = (T)lagrange(P, i, t[g] * t[j]);
+        }
+
+    int count = in.count_elements;
+    eta.resize(count);
+
+    #pragma omp parallel for
+    for (int first = 0; first < count; first += batch)
+    {
+        int n = count - first < batch ? count - first : batch;
+        std::vector<T> x(n * M), lambda(n * M), f(n * M);
+
+        for (int e = 0; e < n; e++)
+        {
+            T x0 = in.nodes[first + e], h = in.nodes[first + e + 1] - x0;
+            T* xe = &x[e * M];
+            for (int g = 0; g < Q; g++)
+            {
+                xe[g] = x0 + h * (T)t[g];
+                for (int j = 0; j < Q; j++)
+                    xe[Q + g * Q + j] = x0 + h * (T)(t[g] * t[j]);
+            }
+        }
+        Functions.lambda(x.data(), lambda.data(), n * Q * (Q + 1));
+        Functions.f(x.data(), f.data(), n * Q * (Q + 1));
+
+        for (int e = 0; e < n; e++)
+        {
+            int k = first + e;
+            T h = in.nodes[k + 1] - in.nodes[k];
+            T gamma = std::get<1>(in.materials[in.elems[k]]);
+            const T* uk = &q[k * P];
+            const T* lk = &lambda[e * M];
+            T* rk = &f[e * M];
+            std::array<T, Q> du{};
+
+            //     s' = f - gamma u_h    
+            for (int i = 0; i < N; i++)
+            {
+                T c = gamma * uk[i];
+                for (int m = 0; m < M; m++)
+                    rk[m] -= c * phi[i][m];
+                for (int g = 0; g < Q; g++)
+                    du[g] += uk[i] * dphi[i][g];
+            }
+
+            T total = 0;
+            for (int g = 0; g < Q; g++)
+                total += (T)w[g] * rk[g];
+            total *= h;
+
+            T sum = 0;
+            for (int g = 0; g < Q; g++)
+            {
+                T integral = 0;
+                for (int j = 0; j < Q; j++)
+                    integral += (T)w[j] * rk[Q + g * Q + j];
+                integral *= h * (T)t[g];
+
+                T left = flux[k * P] + integral;
+                T right = flux[(k + 1) * P] - (total - integral);
+                T s = (1 - (T)t[g]) * left + (T)t[g] * right;
+                T d = s + lk[g] * du[g] / h;
+                sum += (T)w[g] * d * d / lk[g];
+            }
+            eta[k] = sum * h;
+        }
+    }
+}
+
+template<typename T>
+void recovery_indicator(grid_in& in, const std::vector<T>& q, IInputFunctions<T>& Functions, std::vector<T>& eta)
+{
+    switch (in.basis)
+    {
+    case 1: recovery_indicator<T, 1>(in, q, Functions, eta); break;
+    case 2: recovery_indicator<T, 2>(in, q, Functions, eta); break;
+    case 3: recovery_indicator<T, 3>(in, q, Functions, eta); break;
+    case 4: recovery_indicator<T, 4>(in, q, Functions, eta); break;
+    case 5: recovery_indicator<T, 5>(in, q, Functions, eta); break;
+    case 6: recovery_indicator<T, 6>(in, q, Functions, eta); break;
+    case 7: recovery_indicator<T, 7>(in, q, Functions, eta); break;
+    case 8: recovery_indicator<T, 8>(in, q, Functions, eta); break;
+    default:
+        throw new std::invalid_argument("Invalid basis in input");
+    }
+}
+
+//   ĸ   limit : marked[k] = true  .
+//    .
+template<typename T>
+int dorfler_marking(const std::vector<T>& eta, T theta, int limit, std::vector<bool>& marked)
+{
+    int count = (int)eta.size();
+    std::vector<int> order(count);
+    for (int k = 0; k < count; k++)
+        order[k] = k;
+    //       ,      
+    std::sort(order.begin(), order.end(), [&](int a, int b)
+    {
+        return eta[a] > eta[b] || (eta[a] == eta[b] && a < b);
+    });
+
+    T total = 0;
+    for (int k = 0; k < count; k++)
+        total += eta[order[k]];
+
+    marked.assign(count, false);
+    T sum = 0;
+    int m = 0;
+    while (m < count && m < limit && sum < theta * total)
+    {
+        sum += eta[order[m]];
+        marked[order[m++]] = true;
+    }
+    return m;
+}
+
+//     .    .
+inline void refine(grid_in& in, const std::vector<bool>& marked)
+{
+    std::vector<double> nodes;
+    std::vector<int> elems;
+    nodes.reserve(in.nodes.size() * 2);
+    elems.reserve(in.elems.size() * 2);
+
+    for (int k = 0; k < in.count_elements; k++)
+    {
+        nodes.push_back(in.nodes[k]);
+        elems.push_back(in.elems[k]);
+        if (marked[k])
+        {
+            nodes.push_back((in.nodes[k] + in.nodes[k + 1]) / 2);
+            elems.push_back(in.elems[k]);
+        }
+    }
+    nodes.push_back(in.nodes[in.count_elements]);
+
+    in.nodes.swap(nodes);
+    in.elems.swap(elems);
+    in.count_elements = (int)in.elems.size();
+    in.count_nodes = in.count_elements + 1;
+}
+
+//   : in -  ,   -  ,
+// q -   , eta -      .
+template<typename T>
+AdaptiveResult<T> solve_adaptive(grid_in& in, IInputFunctions<T>& Functions, std::vector<T>& q,
+    const AdaptiveOptions<T>& options, std::vector<T>& eta)
+{
+    AdaptiveResult<T> result;
+    std::vector<bool> marked;
+
+    while (true)
+    {
+        Matrix<T> m;
+        m.solve_FEM(in, Functions, q);
+        recovery_indicator(in, q, Functions, eta);
+
+        T sum = 0;
+        for (int k = 0; k < in.count_elements; k++)
+            sum += eta[k];
+        result.estimate = std::sqrt(sum);
+        result.dofs = (int)q.size();
+        result.steps++;
+
+        //     ,    max_dofs
+        int limit = (options.max_dofs - 1) / in.basis - in.count_elements;
+        if (result.estimate <= options.tolerance || result.steps >= options.max_steps || limit <= 0)
+            break;
+
+        if (dorfler_marking(eta, options.theta, limit, marked) == 0)
+            break;
+        refine(in, marked);
+    }
+    return result;
+}
@@ -0,0 +1,177 @@
+#pragma once
+#include <vector>
+#include <stdexcept>
+
+//        p.
+//  i  p     :
+//  (i, j), i - p <= j < i,   al[i * p + j - i + p].
+// ,     ,  .
+//  LDLT,       O(dim * p).
+template<typename T>
+class BandMatrix
+{
+public:
+    int dim = 0;
+    //  
+    int p = 0;
+    std::vector<T> al, di;
+
+    //      dim    p   .
+    void init(int dim, int p)
+    {
+        this->dim = dim;
+        this->p = p;
+        di.assign(dim, 0);
+        al.assign((size_t)dim * p, 0);
+    }
+
+    //   , i > j  i - j <= p.
+    T& elem(int i, int j)
+    {
+        return al[(size_t)i * p + j - i + p];
+    }
+
+    //  LDLT  .
+    //   al  L   , di -  D.
+    //      solve(vector<T>, vector<T>)
+    void factorization()
+    {
+        factorization(0, dim);
+    }
+
+    //  LDLT     [begin, end).
+    //    begin  ,   , 
+    //    ,     .
+    void factorization(int begin, int end)
+    {
+        // w[j - i + p] = L[i][j] * D[j]    i
+        std::vector<T> w(p);
+        factorization(begin, end, begin, w);
+    }
+
+    //  :  [begin, end)      ,
+    //      .    
+    //   ,   . w -    p.
+    void factorization_rows(int begin, int end, std::vector<T>& w)
+    {
+        factorization(begin, end, 0, w);
+    }
+
+    //     [begin, end),  y     .
+    void forward_rows(std::vector<T>& y, const std::vector<T>& b, int begin, int end)
+    {
+        forward(y, b, begin, end, 0);
+    }
+
+    //  , Ly = b. y  b  .
+    void forward(std::vector<T>& y, const std::vector<T>& b)
+    {
+        forward(y, b, 0, dim);
+    }
+
+    //      [begin, end),  factorization(begin, end).
+    void forward(std::vector<T>& y, const std::vector<T>& b, int begin, int end)
+    {
+        forward(y, b, begin, end, begin);
+    }
+
+    //  , DL^T x = y. x  y  .
+    //    L^T:   x[i] ,   
+    //   p ,   .
+    void backward(std::vector<T>& x, const std::vector<T>& y)
+    {
+        backward(x, y, 0, dim);
+    }
+
+    //      [begin, end).
+    void backward(std::vector<T>& x, const std::vector<T>& y, int begin, int end)
+    {
+        for (int i = begin; i < end; i++)
+            x[i] = y[i] / di[i];
+
+        for (int i = end - 1; i >= begin; i--)
+        {
+            const T* li = &al[(size_t)i * p];
+            int j0 = i - p < begin ? begin : i - p;
+            T xi = x[i];
+
+            for (int j = j0; j < i; j++)
+                x[j] -= li[j - i + p] * xi;
+        }
+    }
+
+    //  y = Ax   ( ) . x  y   .
+    void multiply(const std::vector<T>& x, std::vector<T>& y) const
+    {
+        y.resize(dim);
+        #pragma omp parallel for
+        for (int i = 0; i < dim; i++)
+        {
+            const T* li = &al[(size_t)i * p];
+            int j0 = i - p < 0 ? 0 : i - p;
+            int j1 = i + p < dim ? i + p : dim - 1;
+            T sum = di[i] * x[i];
+
+            for (int j = j0; j < i; j++)
+                sum += li[j - i + p] * x[j];
+            //   -  i 
+            for (int j = i + 1; j <= j1; j++)
+                sum += al[(size_t)j * p + i - j + p] * x[j];
+            y[i] = sum;
+        }
+    }
+
+    //    Ax = b    .
+    // x  b  .
+    void solve(std::vector<T>& x, const std::vector<T>& b)
+    {
+        x.resize(dim);
+        forward(x, b);
+        backward(x, x);
+    }
+
+private:
+    //   [begin, end),   left  .
+    void factorization(int begin, int end, int left, std::vector<T>& w)
+    {
+        for (int i = begin; i < end; i++)
+        {
+            T* li = &al[(size_t)i * p];
+            int j0 = i - p < left ? left : i - p;
+            T sum_di = 0;
+
+            for (int j = j0; j < i; j++)
+            {
+                const T* lj = &al[(size_t)j * p];
+                T sum = 0;
+                for (int k = j0; k < j; k++)
+                    sum += w[k - i + p] * lj[k - j + p];
+
+                T a = li[j - i + p] - sum;
+                w[j - i + p] = a;
+                li[j - i + p] = a / di[j];
+                sum_di += a * li[j - i + p];
+            }
+
+            di[i] -= sum_di;
+            if (di[i] == 0)
+                throw new std::invalid_argument("Matrix is singular");
+        }
+    }
+
+    //     [begin, end),   left  .
+    void forward(std::vector<T>& y, const std::vector<T>& b, int begin, int end, int left)
+    {
+        for (int i = begin; i < end; i++)
+        {
+            const T* li = &al[(size_t)i * p];
+            int j0 = i - p < left ? left : i - p;
+            T elem = b[i];
+
+            for (int j = j0; j < i; j++)
+                elem -= li[j - i + p] * y[j];
+
+            y[i] = elem;
+        }
+    }
+};
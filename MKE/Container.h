@@ -0,0 +1,335 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <memory>
+#include <fstream>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include "Grid.h"
+#include "Functions.h"
+#include "MappedFile.h"
+
+/*
+      .
+
+     container_header,  ,    8 :
+     (nodes, elems, materials -    , conditions) ,  ,
+      Matrix::prepare_FEM (ia, di, al  ,  
+     ).     :    grid_in,
+         ,  .
+
+    grid_hash -    , factor_hash -    
+      ,   (factor_flags,    ).
+       factor_hash    (ToString),      
+     (lambda_hash):   ,      .
+      ,        ,      .
+*/
+
+const char container_magic[8] = "FEMDIVG";
+const uint32_t container_version = 3;
+
+enum container_section
+{
+    section_nodes, section_elems, section_materials, section_conditions,
+    section_ia, section_di, section_al, section_dirichlet_left, section_dirichlet_right,
+    section_count
+};
+
+//  ,      .
+enum factor_flag
+{
+    factor_constant_materials = 1
+};
+
+struct container_header
+{
+    char magic[8];
+    uint32_t version;
+    //     , 0 -    
+    uint32_t factor_real;
+    uint64_t grid_hash, factor_hash;
+    int32_t count_elements, count_nodes, count_materials, basis;
+    int32_t left, right;
+    //      
+    int32_t dim, factor_basis;
+    //    (factor_flag)  
+    uint32_t factor_flags, reserved;
+    //      
+    uint64_t offset[section_count];
+    uint64_t size[section_count];
+};
+
+//  FNV-1a, hash -   .
+inline uint64_t fnv1a(const void* data, size_t size, uint64_t hash = 14695981039346656037ULL)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    return hash;
+}
+
+//       path (. input).
+inline uint64_t grid_hash(std::string path)
+{
+    const char* names[] = { "info.txt", "conditions.txt", "materials.txt", "nodes.txt", "elements.txt", "mesh.txt" };
+    uint64_t hash = fnv1a(&container_version, sizeof(container_version));
+
+    for (const char* name : names)
+    {
+        MappedFile file;
+        bool exists = file.open(path + "/" + name);
+        uint64_t size = file.size();
+
+        hash = fnv1a(name, std::strlen(name), hash);
+        hash = fnv1a(&exists, sizeof(exists), hash);
+        hash = fnv1a(&size, sizeof(size), hash);
+        hash = fnv1a(file.data(), file.size(), hash);
+    }
+    return hash;
+}
+
+//   Functions.lambda    - ,    .
+//    ,     batch .
+template<typename T>
+uint64_t lambda_hash(grid_in& in, IInputFunctions<T>& Functions)
+{
+    const int batch = 256;
+    int N = in.basis + 1;
+    std::vector<T> x((size_t)batch * N), lambda((size_t)batch * N);
+    uint64_t hash = fnv1a(&N, sizeof(N));
+
+    for (int first = 0; first < in.count_elements; first += batch)
+    {
+        int n = in.count_elements - first < batch ? in.count_elements - first : batch;
+        for (int e = 0; e < n; e++)
+            element_nodes(in, first + e, &x[(size_t)e * N]);
+        Functions.lambda(x.data(), lambda.data(), n * N);
+        hash = fnv1a(lambda.data(), (size_t)n * N * sizeof(T), hash);
+    }
+    return hash;
+}
+
+//  : ,   ( ToString   lambda_hash),     .
+inline uint64_t factor_hash(uint64_t grid, std::string functions, uint64_t lambda, uint32_t real, uint32_t flags)
+{
+    uint64_t hash = fnv1a(&grid, sizeof(grid));
+    hash = fnv1a(functions.data(), functions.size(), hash);
+    hash = fnv1a(&lambda, sizeof(lambda), hash);
+    hash = fnv1a(&real, sizeof(real), hash);
+    return fnv1a(&flags, sizeof(flags), hash);
+}
+
+//  .     ,  -  factor.
+class ContainerWriter
+{
+public:
+    ContainerWriter(grid_in& in, uint64_t grid_hash)
+    {
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, container_magic, sizeof(header.magic));
+        header.version = container_version;
+        header.grid_hash = grid_hash;
+        header.count_elements = in.count_elements;
+        header.count_nodes = in.count_nodes;
+        header.count_materials = in.count_materials;
+        header.basis = in.basis;
+        header.left = std::get<0>(in.r_cond);
+        header.right = std::get<1>(in.r_cond);
+
+        for (auto& material : in.materials)
+        {
+            materials.push_back(std::get<0>(material));
+            materials.push_back(std::get<1>(material));
+        }
+
+        section(section_nodes, in.nodes.data(), in.nodes.size());
+        section(section_elems, in.elems.data(), in.elems.size());
+        section(section_materials, materials.data(), materials.size());
+        section(section_conditions, in.conditions.data(), in.conditions.size());
+    }
+
+    //      .
+    template<typename T>
+    void factor(uint64_t hash, uint32_t flags, int dim, int basis, const std::vector<int>& ia, const std::vector<T>& di,
+        const std::vector<T>& al, const std::vector<T>& dirichlet_left, const std::vector<T>& dirichlet_right)
+    {
+        header.factor_real = sizeof(T);
+        header.factor_hash = hash;
+        header.factor_flags = flags;
+        header.dim = dim;
+        header.factor_basis = basis;
+        section(section_ia, ia.data(), ia.size());
+        section(section_di, di.data(), di.size());
+        // al    :      ia[dim]
+        section(section_al, al.data(), (size_t)ia[dim]);
+        section(section_dirichlet_left, dirichlet_left.data(), dirichlet_left.size());
+        section(section_dirichlet_right, dirichlet_right.data(), dirichlet_right.size());
+    }
+
+    //  .          ,
+    //        .
+    void write(std::string path)
+    {
+        uint64_t offset = align(sizeof(header));
+        for (int s = 0; s < section_count; s++)
+        {
+            header.offset[s] = offset;
+            offset = align(offset + header.size[s]);
+        }
+
+        std::string temp = path + ".tmp";
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+            throw new std::invalid_argument("Can not open file " + temp);
+
+        out.write((const char*)&header, sizeof(header));
+        for (int s = 0; s < section_count; s++)
+        {
+            out.seekp(header.offset[s]);
+            out.write((const char*)data[s], header.size[s]);
+        }
+        //    
+        if ((uint64_t)out.tellp() < offset)
+        {
+            out.seekp(offset - 1);
+            out.put(0);
+        }
+        out.close();
+        if (!out)
+            throw new std::runtime_error("Can not write file " + temp);
+
+        std::remove(path.c_str());
+        if (std::rename(temp.c_str(), path.c_str()) != 0)
+            throw new std::runtime_error("Can not rename " + temp + " to " + path);
+    }
+
+private:
+    container_header header;
+    std::vector<double> materials;
+    const void* data[section_count] = {};
+
+    static uint64_t align(uint64_t offset)
+    {
+        return (offset + 7) / 8 * 8;
+    }
+
+    template<typename V>
+    void section(container_section s, const V* values, size_t count)
+    {
+        data[s] = values;
+        header.size[s] = count * sizeof(V);
+    }
+};
+
+//      .
+class ContainerReader
+{
+public:
+    //  .  false,         .
+    bool open(std::string path)
+    {
+        if (!file.open(path) || file.size() < sizeof(container_header))
+            return false;
+
+        header = (const container_header*)file.data();
+        if (std::memcmp(header->magic, container_magic, sizeof(header->magic)) != 0 || header->version != container_version)
+            return false;
+
+        for (int s = 0; s < section_count; s++)
+            if (header->offset[s] % 8 != 0 || header->offset[s] > file.size() || header->size[s] > file.size() - header->offset[s])
+                return false;
+
+        return size(section_nodes) == (uint64_t)header->count_nodes * sizeof(double)
+            && size(section_elems) == (uint64_t)header->count_elements * sizeof(int)
+            && size(section_materials) == (uint64_t)header->count_materials * 2 * sizeof(double);
+    }
+
+    const container_header& info() const
+    {
+        return *header;
+    }
+
+    //          T.    
+    //   ia,        ;
+    //  false    .
+    template<typename T>
+    bool has_factor() const
+    {
+        int dim = header->dim, basis = header->factor_basis;
+        if (header->factor_real != sizeof(T) || basis < 1 || dim < 2
+            || (int64_t)dim != (int64_t)basis * header->count_elements + 1
+            || size(section_ia) != ((uint64_t)dim + 1) * sizeof(int)
+            || size(section_di) != (uint64_t)dim * sizeof(T))
+            return false;
+
+        //    ,  i   basis      0
+        size_t count;
+        const int* ia = section<int>(section_ia, count);
+        if (ia[0] != 0)
+            return false;
+        for (int i = 0; i < dim; i++)
+        {
+            int row = ia[i + 1] - ia[i];
+            if (row < 0 || row > basis || row > i)
+                return false;
+        }
+        if (size(section_al) != (uint64_t)ia[dim] * sizeof(T))
+            return false;
+
+        //           
+        uint64_t left = header->left == 1 ? basis : 0, right = header->right == 1 ? basis : 0;
+        return size(section_dirichlet_left) == left * sizeof(T)
+            && size(section_dirichlet_right) == right * sizeof(T);
+    }
+
+    //         .
+    template<typename V>
+    const V* section(container_section s, size_t& count) const
+    {
+        count = size(s) / sizeof(V);
+        return (const V*)(file.data() + header->offset[s]);
+    }
+
+    //    out.
+    void grid(grid_in& out) const
+    {
+        size_t count;
+        out.count_elements = header->count_elements;
+        out.count_nodes = header->count_nodes;
+        out.count_materials = header->count_materials;
+        out.basis = header->basis;
+        out.r_cond = std::make_tuple(header->left, header->right);
+
+        const double* nodes = section<double>(section_nodes, count);
+        out.nodes.assign(nodes, nodes + count);
+        const int* elems = section<int>(section_elems, count);
+        out.elems.assign(elems, elems + count);
+        const double* conditions = section<double>(section_conditions, count);
+        out.conditions.assign(conditions, conditions + count);
+
+        const double* materials = section<double>(section_materials, count);
+        out.materials.resize(out.count_materials);
+        for (int i = 0; i < out.count_materials; i++)
+            out.materials[i] = std::make_tuple(materials[2 * i], materials[2 * i + 1]);
+    }
+
+private:
+    MappedFile file;
+    const container_header* header = nullptr;
+
+    uint64_t size(container_section s) const
+    {
+        return header->size[s];
+    }
+};
+
+//     path      container.
+//   ,      Matrix::prepare_FEM  .
+inline void convert_problem(std::string path, std::string container)
+{
+    grid_in in;
+    input(path, in);
+    ContainerWriter(in, grid_hash(path)).write(container);
+}
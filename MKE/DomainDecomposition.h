@@ -0,0 +1,167 @@
+#pragma once
+#include <vector>
+#include <stdexcept>
+#include "BandMatrix.h"
+
+/*
+          .
+
+      cells  ( p   )   parts 
+       .     -  ,
+      - .    
+        , :
+    1)    LDLT ,  ,    A;
+    2)        parts - 1  ;
+    3)       .
+            .
+
+    A -      ,    
+      . x  b  .
+*/
+template<typename T>
+void solve_dd(BandMatrix<T>& A, std::vector<T>& b, std::vector<T>& x, int parts)
+{
+    int p = A.p;
+    int dim = A.dim;
+    int cells = (dim - 1) / p;
+
+    //          
+    if (parts > cells / 2)
+        parts = cells / 2;
+    if (parts < 2)
+    {
+        A.factorization();
+        A.solve(x, b);
+        return;
+    }
+
+    // s[t] -       t (s[0]  ),
+    //  t   [begin[t], end[t]).
+    std::vector<int> s(parts + 1), begin(parts), end(parts);
+    for (int t = 0; t <= parts; t++)
+        s[t] = (int)((long long)cells * t / parts) * p;
+    for (int t = 0; t < parts; t++)
+    {
+        begin[t] = t == 0 ? 0 : s[t] + 1;
+        end[t] = t == parts - 1 ? dim : s[t + 1];
+    }
+
+    //   t   :
+    // left_left -    , right_right - ,
+    // left_right -     , g_left  g_right -   .
+    std::vector<T> left_left(parts, 0), right_right(parts, 0), left_right(parts, 0);
+    std::vector<T> g_left(parts, 0), g_right(parts, 0);
+    std::vector<T> rhs(b), z_b(dim), z_left(dim), z_right(dim);
+
+    //      :  
+    //         
+    std::vector<std::invalid_argument*> errors(parts, nullptr);
+    #pragma omp parallel for
+    for (int t = 0; t < parts; t++)
+    {
+        try
+        {
+            int i0 = begin[t], i1 = end[t];
+            bool has_left = t > 0, has_right = t < parts - 1;
+            int left = s[t], right = s[t + 1];
+
+            A.factorization(i0, i1);
+            A.forward(z_b, rhs, i0, i1);
+            A.backward(z_b, z_b, i0, i1);
+
+            // z_left = A_tt^-1 * (  ),        p 
+            if (has_left)
+            {
+                for (int i = i0; i < i1; i++)
+                    z_left[i] = i - left <= p ? A.elem(i, left) : 0;
+                A.forward(z_left, z_left, i0, i1);
+                A.backward(z_left, z_left, i0, i1);
+            }
+
+            //    -   right    p  
+            if (has_right)
+            {
+                for (int i = i0; i < i1; i++)
+                    z_right[i] = right - i <= p ? A.elem(right, i) : 0;
+                A.forward(z_right, z_right, i0, i1);
+                A.backward(z_right, z_right, i0, i1);
+            }
+
+            for (int i = i0; i < i1 && i - left <= p; i++)
+                if (has_left)
+                {
+                    T c = A.elem(i, left);
+                    left_left[t] += c * z_left[i];
+                    g_left[t] += c * z_b[i];
+                    if (has_right)
+                        left_right[t] += c * z_right[i];
+                }
+
+            for (int i = i1 - 1; i >= i0 && right - i <= p; i--)
+                if (has_right)
+                {
+                    T c = A.elem(right, i);
+                    right_right[t] += c * z_right[i];
+                    g_right[t] += c * z_b[i];
+                }
+        }
+        catch (std::invalid_argument* e)
+        {
+            errors[t] = e;
+        }
+    }
+
+    for (int t = 0; t < parts; t++)
+        if (errors[t] != nullptr)
+        {
+            std::invalid_argument* error = errors[t];
+            for (int k = t + 1; k < parts; k++)
+                delete errors[k];
+            throw error;
+        }
+
+    //      s[1..parts-1]
+    int count = parts - 1;
+    BandMatrix<T> S;
+    std::vector<T> u(count);
+    S.init(count, 1);
+    for (int k = 0; k < count; k++)
+    {
+        int node = s[k + 1];
+        //  k    k (  )  k + 1 ()
+        S.di[k] = A.di[node] - right_right[k] - left_left[k + 1];
+        u[k] = rhs[node] - g_right[k] - g_left[k + 1];
+
+        if (k > 0)
+        {
+            int prev = s[k];
+            T a = node - prev <= p ? A.elem(node, prev) : 0;
+            S.elem(k, k - 1) = a - left_right[k];
+        }
+    }
+    S.factorization();
+    S.solve(u, u);
+
+    //  : A_tt u_t = b_t - A_tL u_L - A_tR u_R
+    #pragma omp parallel for
+    for (int t = 0; t < parts; t++)
+    {
+        int i0 = begin[t], i1 = end[t];
+        int left = s[t], right = s[t + 1];
+
+        if (t > 0)
+            for (int i = i0; i < i1 && i - left <= p; i++)
+                rhs[i] -= A.elem(i, left) * u[t - 1];
+        if (t < parts - 1)
+            for (int i = i1 - 1; i >= i0 && right - i <= p; i--)
+                rhs[i] -= A.elem(right, i) * u[t];
+
+        A.forward(rhs, rhs, i0, i1);
+        A.backward(rhs, rhs, i0, i1);
+    }
+
+    for (int k = 0; k < count; k++)
+        rhs[s[k + 1]] = u[k];
+
+    x.swap(rhs);
+}
@@ -0,0 +1,258 @@
+#pragma once
+#include <array>
+
+/*
+        P (1..max_basis)  
+        [0, 1].
+
+          -:
+    M[i][j]     = int phi_i phi_j,
+    G[i][j]     = int phi_i' phi_j',
+    GL[m][i][j] = int phi_m phi_i' phi_j' -       ,
+    MM[m][i][j] = int phi_m phi_i phi_j   -       .
+     P = 2  P = 3      LocalMatrix.h.
+
+        h: A = 1/h * sum_m lambda_m GL[m] + gamma * h * M,
+     : v = h * M f.    std::array  ,
+               .
+*/
+
+//    .
+const int max_basis = 8;
+
+#pragma region   
+
+//        .
+constexpr double constexpr_cos(double x)
+{
+    const double pi = 3.14159265358979323846;
+    while (x > pi)
+        x -= 2 * pi;
+    while (x < -pi)
+        x += 2 * pi;
+
+    double term = 1, sum = 1;
+    for (int k = 1; k < 30; k++)
+    {
+        term *= -x * x / ((2 * k - 1) * (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+//  x   w  -  n    [0, 1].
+//    ,    .
+constexpr void gauss_legendre(int n, double* x, double* w)
+{
+    const double pi = 3.14159265358979323846;
+    for (int i = 0; i < n; i++)
+    {
+        double t = constexpr_cos(pi * (i + 0.75) / (n + 0.5));
+        double dp = 0;
+
+        //     P_n(t)
+        for (int iter = 0; iter < 100; iter++)
+        {
+            double p0 = 1, p1 = t;
+            for (int k = 1; k < n; k++)
+            {
+                double p2 = ((2 * k + 1) * t * p1 - k * p0) / (k + 1);
+                p0 = p1;
+                p1 = p2;
+            }
+
+            dp = n * (t * p1 - p0) / (t * t - 1);
+            double dt = p1 / dp;
+            t -= dt;
+            if (dt < 1e-16 && dt > -1e-16)
+                break;
+        }
+
+        double p0 = 1, p1 = t;
+        for (int k = 1; k < n; k++)
+        {
+            double p2 = ((2 * k + 1) * t * p1 - k * p0) / (k + 1);
+            p0 = p1;
+            p1 = p2;
+        }
+        dp = n * (t * p1 - p0) / (t * t - 1);
+
+        x[n - 1 - i] = (t + 1) / 2;
+        w[n - 1 - i] = 1 / ((1 - t * t) * dp * dp);
+    }
+}
+
+//    i  P   ksi.
+constexpr double lagrange(int P, int i, double ksi)
+{
+    double value = 1;
+    for (int j = 0; j <= P; j++)
+        if (j != i)
+            value *= (ksi * P - j) / (i - j);
+    return value;
+}
+
+//     i  P   ksi.
+constexpr double lagrange_derivative(int P, int i, double ksi)
+{
+    double value = 0;
+    for (int m = 0; m <= P; m++)
+    {
+        if (m == i)
+            continue;
+
+        double term = double(P) / (i - m);
+        for (int j = 0; j <= P; j++)
+            if (j != i && j != m)
+                term *= (ksi * P - j) / (i - j);
+        value += term;
+    }
+    return value;
+}
+
+//     P.
+template<int P>
+struct ReferenceElement
+{
+    static constexpr int N = P + 1;
+    //      3P,    MM ( GL -  3P - 2).
+    static constexpr int Q = (3 * P) / 2 + 1;
+
+    std::array<std::array<double, N>, N> M{};
+    std::array<std::array<double, N>, N> G{};
+    std::array<std::array<std::array<double, N>, N>, N> GL{};
+    std::array<std::array<std::array<double, N>, N>, N> MM{};
+    // monomial[i][m] -   ksi^m    i
+    std::array<std::array<double, N>, N> monomial{};
+    // derivative[i][j] -   ksi   j   i
+    std::array<std::array<double, N>, N> derivative{};
+
+    constexpr ReferenceElement()
+    {
+        for (int i = 0; i < N; i++)
+        {
+            //   (ksi * P - j) / (i - j)  j != i
+            monomial[i][0] = 1;
+            int degree = 0;
+            for (int j = 0; j <= P; j++)
+            {
+                if (j == i)
+                    continue;
+                for (int m = degree + 1; m > 0; m--)
+                    monomial[i][m] = (monomial[i][m - 1] * P - monomial[i][m] * j) / (i - j);
+                monomial[i][0] = -monomial[i][0] * j / (i - j);
+                degree++;
+            }
+        }
+
+        for (int i = 0; i < N; i++)
+            for (int j = 0; j < N; j++)
+                derivative[i][j] = lagrange_derivative(P, j, double(i) / P);
+
+        double x[Q] = {}, w[Q] = {};
+        double phi[N][Q] = {}, dphi[N][Q] = {};
+        gauss_legendre(Q, x, w);
+
+        for (int i = 0; i < N; i++)
+            for (int q = 0; q < Q; q++)
+            {
+                phi[i][q] = lagrange(P, i, x[q]);
+                dphi[i][q] = lagrange_derivative(P, i, x[q]);
+            }
+
+        for (int i = 0; i < N; i++)
+            for (int j = 0; j <= i; j++)
+            {
+                double m = 0, g = 0;
+                for (int q = 0; q < Q; q++)
+                {
+                    m += w[q] * phi[i][q] * phi[j][q];
+                    g += w[q] * dphi[i][q] * dphi[j][q];
+                }
+                M[i][j] = M[j][i] = m;
+                G[i][j] = G[j][i] = g;
+
+                for (int k = 0; k < N; k++)
+                {
+                    double gl = 0, mm = 0;
+                    for (int q = 0; q < Q; q++)
+                    {
+                        gl += w[q] * phi[k][q] * dphi[i][q] * dphi[j][q];
+                        mm += w[q] * phi[k][q] * phi[i][q] * phi[j][q];
+                    }
+                    GL[k][i][j] = GL[k][j][i] = gl;
+                    MM[k][i][j] = MM[k][j][i] = mm;
+                }
+            }
+    }
+};
+
+#pragma endregion
+
+//    P    .
+template<typename T, int P>
+struct Element
+{
+    static constexpr int N = P + 1;
+    static constexpr ReferenceElement<P> reference{};
+
+    typedef std::array<std::array<T, N>, N> matrix_type;
+    typedef std::array<T, N> vector_type;
+
+    //    ,    (N  lambda   ).
+    static void matrix(const T* lambda, T gamma, T h, matrix_type& A)
+    {
+        T coefG = 1 / h;
+        T coefM = gamma * h;
+
+        for (int i = 0; i < N; i++)
+            for (int j = 0; j <= i; j++)
+            {
+                T g = 0;
+                for (int m = 0; m < N; m++)
+                    g += lambda[m] * reference.GL[m][i][j];
+                A[i][j] = A[j][i] = g * coefG + reference.M[i][j] * coefM;
+            }
+    }
+
+    //  ,    ,      ( N   ).
+    static void matrix(const T* lambda, const T* gamma, T h, matrix_type& A)
+    {
+        T coefG = 1 / h;
+
+        for (int i = 0; i < N; i++)
+            for (int j = 0; j <= i; j++)
+            {
+                T g = 0, m = 0;
+                for (int k = 0; k < N; k++)
+                {
+                    g += lambda[k] * reference.GL[k][i][j];
+                    m += gamma[k] * reference.MM[k][i][j];
+                }
+                A[i][j] = A[j][i] = g * coefG + m * h;
+            }
+    }
+
+    //         .
+    static void matrix(T lambda, T gamma, T h, matrix_type& A)
+    {
+        T coefG = lambda / h;
+        T coefM = gamma * h;
+
+        for (int i = 0; i < N; i++)
+            for (int j = 0; j < N; j++)
+                A[i][j] = reference.G[i][j] * coefG + reference.M[i][j] * coefM;
+    }
+
+    //      N  f   .
+    static void vector(const T* f, T h, vector_type& v)
+    {
+        for (int i = 0; i < N; i++)
+        {
+            T sum = 0;
+            for (int j = 0; j < N; j++)
+                sum += reference.M[i][j] * f[j];
+            v[i] = sum * h;
+        }
+    }
+};
@@ -0,0 +1,262 @@
+#pragma once
+#include <vector>
+#include <tuple>
+#include <stdexcept>
+#include "Grid.h"
+#include "LocalMatrix.h"
+
+/*
+      W       ,
+        ()   .
+            IInputFunctions,    solve_FEM.
+
+         (. BandMatrix),   
+      :  (i, j)  w   al[(i * p + j - i + p) * W + w].
+    ,  LDLT        W ,
+        -    W    ,
+      . W     :
+    4  AVX2, 8  AVX-512  T = double.
+*/
+
+template<typename T, int W>
+class Ensemble
+{
+public:
+    int dim = 0;
+    //  
+    int p = 0;
+    std::vector<T> al, di, b;
+
+    //   W .  in      .
+    // q[w] -   in[w].
+    void solve(std::vector<grid_in>& in, IInputFunctions<T>& Functions, std::vector<std::vector<T>>& q)
+    {
+        int count = in.size();
+        if (count == 0 || count > W)
+            throw new std::invalid_argument("Ensemble size have to be in range [1, W]");
+
+        for (int w = 1; w < count; w++)
+            if (in[w].count_elements != in[0].count_elements || in[w].basis != in[0].basis || in[w].nodes != in[0].nodes)
+                throw new std::invalid_argument("All problems in ensemble have to share the same grid and basis");
+
+        if (in[0].basis == 2)
+        {
+            LocalMatrix2_lambda<T> stiffness(Functions);
+            LocalMatrix2<T> mass;
+            LocalVector2<T> localVector(Functions);
+            global_matrix(in, stiffness, mass, localVector);
+        }
+        else if (in[0].basis == 3)
+        {
+            LocalMatrix3_lambda<T> stiffness(Functions);
+            LocalMatrix3<T> mass;
+            LocalVector3<T> localVector(Functions);
+            global_matrix(in, stiffness, mass, localVector);
+        }
+        else
+            throw new std::invalid_argument("Invalid basis in input");
+
+        for (int w = 0; w < W; w++)
+            conditions(in[w < count ? w : 0], w);
+
+        factorization();
+        forward();
+        backward();
+
+        q.resize(count);
+        for (int w = 0; w < count; w++)
+        {
+            q[w].resize(dim);
+            for (int i = 0; i < dim; i++)
+                q[w][i] = b[i * W + w];
+        }
+    }
+
+private:
+    //    (i > j)  w
+    T& elem(int i, int j, int w)
+    {
+        return al[((size_t)i * p + j - i + p) * W + w];
+    }
+
+    //       .
+    //        ,   :
+    // A_w = G + gamma_w * M.
+    void global_matrix(std::vector<grid_in>& in, ILocalMatrix<T>& stiffness, ILocalMatrix<T>& mass, ILocalVector<T>& localVector)
+    {
+        grid_in& grid = in[0];
+        int count = in.size();
+        p = grid.basis;
+        dim = p * grid.count_elements + 1;
+        al.assign((size_t)dim * p * W, 0);
+        di.assign((size_t)dim * W, 0);
+        b.assign((size_t)dim * W, 0);
+
+        std::vector<T> x(p + 1);
+        std::tuple<double, double> no_gamma(0, 0), unit_gamma(0, 1);
+        T gamma[W];
+
+        for (int k = 0; k < grid.count_elements; k++)
+        {
+            //     ,    
+            for (int w = 0; w < W; w++)
+                gamma[w] = std::get<1>(in[w < count ? w : 0].materials[in[w < count ? w : 0].elems[k]]);
+
+            element_nodes(grid, k, x.data());
+            std::vector<std::vector<T>>& G = *stiffness.get_matrix(x, no_gamma);
+            std::vector<std::vector<T>>& M = *mass.get_matrix(x, unit_gamma);
+            std::vector<T>& v = *localVector.get_vector(x);
+
+            for (int i = 0; i <= p; i++)
+            {
+                int row = k * p + i;
+                T* d = &di[(size_t)row * W];
+                T* r = &b[(size_t)row * W];
+                for (int w = 0; w < W; w++)
+                {
+                    d[w] += G[i][i] + gamma[w] * M[i][i];
+                    r[w] += v[i];
+                }
+
+                for (int j = 0; j < i; j++)
+                {
+                    T* a = &elem(row, k * p + j, 0);
+                    for (int w = 0; w < W; w++)
+                        a[w] += G[i][j] + gamma[w] * M[i][j];
+                }
+            }
+        }
+    }
+
+    //     in   w.
+    //   ,    Matrix::conditions:  ,  .
+    void conditions(grid_in& in, int w)
+    {
+        int first_border = std::get<0>(in.r_cond);
+        int second_border = std::get<1>(in.r_cond);
+        int index = 0;
+        int last = dim - 1;
+
+        if (first_border == 2)
+            b[w] += in.conditions[index++];
+        else if (first_border == 3)
+        {
+            di[w] += in.conditions[index++];        // beta
+            b[w] += in.conditions[index++];         // ubeta
+        }
+
+        if (second_border == 2)
+            b[last * W + w] += in.conditions[index++];
+        else if (second_border == 3)
+        {
+            double beta = in.conditions[index++];
+            di[last * W + w] += beta;
+            b[last * W + w] += beta * in.conditions[index++];
+        }
+
+        if (first_border == 1)
+        {
+            di[w] = 1;
+            b[w] = in.conditions[index++];
+            for (int i = 1; i <= p; i++)
+            {
+                b[i * W + w] += -elem(i, 0, w) * b[w];
+                elem(i, 0, w) = 0;
+            }
+        }
+
+        if (second_border == 1)
+        {
+            di[last * W + w] = 1;
+            b[last * W + w] = in.conditions[index];
+            for (int j = last - p; j < last; j++)
+            {
+                b[j * W + w] += -elem(last, j, w) * b[last * W + w];
+                elem(last, j, w) = 0;
+            }
+        }
+    }
+
+    //  LDLT   , . BandMatrix::factorization.
+    void factorization()
+    {
+        std::vector<T> buffer((size_t)p * W);
+        T sum[W], sum_di[W];
+
+        for (int i = 0; i < dim; i++)
+        {
+            int j0 = i - p < 0 ? 0 : i - p;
+            T* di_i = &di[(size_t)i * W];
+
+            for (int w = 0; w < W; w++)
+                sum_di[w] = 0;
+
+            for (int j = j0; j < i; j++)
+            {
+                for (int w = 0; w < W; w++)
+                    sum[w] = 0;
+
+                for (int k = j0; k < j; k++)
+                {
+                    const T* wk = &buffer[(size_t)(k - i + p) * W];
+                    const T* ljk = &elem(j, k, 0);
+                    for (int w = 0; w < W; w++)
+                        sum[w] += wk[w] * ljk[w];
+                }
+
+                T* lij = &elem(i, j, 0);
+                T* wj = &buffer[(size_t)(j - i + p) * W];
+                const T* dj = &di[(size_t)j * W];
+                for (int w = 0; w < W; w++)
+                {
+                    T a = lij[w] - sum[w];
+                    wj[w] = a;
+                    lij[w] = a / dj[w];
+                    sum_di[w] += a * lij[w];
+                }
+            }
+
+            for (int w = 0; w < W; w++)
+                di_i[w] -= sum_di[w];
+        }
+    }
+
+    //   Ly = b   ,    b.
+    void forward()
+    {
+        for (int i = 0; i < dim; i++)
+        {
+            int j0 = i - p < 0 ? 0 : i - p;
+            T* bi = &b[(size_t)i * W];
+
+            for (int j = j0; j < i; j++)
+            {
+                const T* lij = &elem(i, j, 0);
+                const T* bj = &b[(size_t)j * W];
+                for (int w = 0; w < W; w++)
+                    bi[w] -= lij[w] * bj[w];
+            }
+        }
+    }
+
+    //   DL^T x = y      L^T,    b.
+    void backward()
+    {
+        for (size_t i = 0; i < (size_t)dim * W; i++)
+            b[i] /= di[i];
+
+        for (int i = dim - 1; i >= 0; i--)
+        {
+            int j0 = i - p < 0 ? 0 : i - p;
+            const T* bi = &b[(size_t)i * W];
+
+            for (int j = j0; j < i; j++)
+            {
+                const T* lij = &elem(i, j, 0);
+                T* bj = &b[(size_t)j * W];
+                for (int w = 0; w < W; w++)
+                    bj[w] -= lij[w] * bi[w];
+            }
+        }
+    }
+};
@@ -0,0 +1,149 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <stdexcept>
+#include "Grid.h"
+#include "Functions.h"
+#include "Element.h"
+#include "Solution.h"
+
+/*
+     -lambda * du/dx   .
+
+    element_flux -         
+    (    ):  k  basis + 1   k * (basis + 1).
+    nodal_flux -      ( q):   
+       ,    -    
+      ,   .      ,
+             ,    .
+           ,    .
+
+       ,    .
+*/
+
+//        P.
+template<typename T, int P>
+void element_flux(grid_in& in, const std::vector<T>& q, IInputFunctions<T>& Functions, std::vector<T>& flux)
+{
+    typedef Element<T, P> element;
+    const int N = element::N;
+    const int batch = 64;
+
+    if ((int)q.size() != P * in.count_elements + 1)
+        throw new std::invalid_argument("Solution size does not match the grid");
+    flux.resize((size_t)in.count_elements * N);
+
+    #pragma omp parallel for
+    for (int first = 0; first < in.count_elements; first += batch)
+    {
+        std::array<T, batch * N> x, lambda;
+        int n = in.count_elements - first < batch ? in.count_elements - first : batch;
+
+        for (int e = 0; e < n; e++)
+            element_nodes(in, first + e, &x[e * N]);
+        Functions.lambda(x.data(), lambda.data(), n * N);
+
+        for (int e = 0; e < n; e++)
+        {
+            int k = first + e;
+            T inverse_h = 1 / (in.nodes[k + 1] - in.nodes[k]);
+            const T* u = &q[k * P];
+            T* out = &flux[(size_t)k * N];
+
+            for (int i = 0; i < N; i++)
+            {
+                T du = 0;
+                for (int j = 0; j < N; j++)
+                    du += element::reference.derivative[i][j] * u[j];
+                out[i] = -lambda[e * N + i] * du * inverse_h;
+            }
+        }
+    }
+}
+
+template<typename T>
+void element_flux(grid_in& in, const std::vector<T>& q, IInputFunctions<T>& Functions, std::vector<T>& flux)
+{
+    switch (in.basis)
+    {
+    case 1: element_flux<T, 1>(in, q, Functions, flux); break;
+    case 2: element_flux<T, 2>(in, q, Functions, flux); break;
+    case 3: element_flux<T, 3>(in, q, Functions, flux); break;
+    case 4: element_flux<T, 4>(in, q, Functions, flux); break;
+    case 5: element_flux<T, 5>(in, q, Functions, flux); break;
+    case 6: element_flux<T, 6>(in, q, Functions, flux); break;
+    case 7: element_flux<T, 7>(in, q, Functions, flux); break;
+    case 8: element_flux<T, 8>(in, q, Functions, flux); break;
+    default:
+        throw new std::invalid_argument("Invalid basis in input");
+    }
+}
+
+//     , flux   q.
+template<typename T>
+void nodal_flux(grid_in& in, const std::vector<T>& q, IInputFunctions<T>& Functions, std::vector<T>& flux)
+{
+    std::vector<T> local;
+    element_flux(in, q, Functions, local);
+
+    int P = in.basis, N = P + 1;
+    int count = in.count_elements;
+    flux.resize(q.size());
+
+    #pragma omp parallel for
+    for (int k = 0; k < count; k++)
+    {
+        const T* f = &local[(size_t)k * N];
+        for (int i = 1; i < P; i++)
+            flux[k * P + i] = f[i];
+
+        //   :      
+        if (k == 0)
+            flux[0] = f[0];
+        else
+        {
+            T h_left = in.nodes[k] - in.nodes[k - 1];
+            T h_right = in.nodes[k + 1] - in.nodes[k];
+            flux[k * P] = (local[(size_t)k * N - 1] * h_right + f[0] * h_left) / (h_left + h_right);
+        }
+    }
+    flux[count * P] = local[(size_t)count * N - 1];
+}
+
+//   count   x   SolutionEvaluator    in,
+//   flux.        (  -  ,
+//   SolutionEvaluator): ,   ,    
+//     ,          .
+template<typename T>
+void point_flux(grid_in& in, const SolutionEvaluator<T>& solution, IInputFunctions<T>& Functions,
+    const T* x, T* flux, int count)
+{
+    const int batch = 64;
+    int P = in.basis, N = P + 1;
+    solution.evaluate_derivative(x, flux, count);
+
+    #pragma omp parallel for
+    for (int first = 0; first < count; first += batch)
+    {
+        T nodes[batch * (max_basis + 1)], lambda[batch * (max_basis + 1)];
+        int element[batch];
+        int n = count - first < batch ? count - first : batch;
+
+        for (int e = 0; e < n; e++)
+        {
+            element[e] = solution.locate(x[first + e]);
+            element_nodes(in, element[e], &nodes[e * N]);
+        }
+        Functions.lambda(nodes, lambda, n * N);
+
+        for (int e = 0; e < n; e++)
+        {
+            int k = element[e];
+            T ksi = (x[first + e] - in.nodes[k]) / (in.nodes[k + 1] - in.nodes[k]);
+            T value = 0;
+            for (int m = 0; m < N; m++)
+                value += lambda[e * N + m] * (T)lagrange(P, m, ksi);
+            flux[first + e] *= -value;
+        }
+    }
+}
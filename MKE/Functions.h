@@ -11,18 +11,128 @@ template<typename T>
 class IInputFunctions
 {
 public:
+	virtual ~IInputFunctions() {}
 	virtual T f(T& x) = 0;
 	virtual T lambda(T& x) = 0;
 	virtual std::string ToString() = 0;
+
+	//  f     count  x,   value.
+	//             .
+	//   -    f  lambda, .  InputFunctions.
+	virtual void f(const T* x, T* value, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			T xi = x[i];
+			value[i] = f(xi);
+		}
+	}
+
+	virtual void lambda(const T* x, T* value, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			T xi = x[i];
+			value[i] = lambda(xi);
+		}
+	}
+};
+
+/*
+	         (CRTP).
+	 Derived   f  lambda,     
+	   (Derived::f),    
+	      .
+	: class test : public InputFunctions<T, test<T>>.
+*/
+template<typename T, class Derived>
+class InputFunctions : public IInputFunctions<T>
+{
+public:
+	using IInputFunctions<T>::f;
+	using IInputFunctions<T>::lambda;
+
+	virtual void f(const T* x, T* value, int count)
+	{
+		Derived& self = static_cast<Derived&>(*this);
+		for (int i = 0; i < count; i++)
+		{
+			T xi = x[i];
+			value[i] = self.Derived::f(xi);
+		}
+	}
+
+	virtual void lambda(const T* x, T* value, int count)
+	{
+		Derived& self = static_cast<Derived&>(*this);
+		for (int i = 0; i < count; i++)
+		{
+			T xi = x[i];
+			value[i] = self.Derived::lambda(xi);
+		}
+	}
+};
+
+/*
+	    -div(lambda(x, u) grad u) + (gamma + g(x, u)) u = f(x),
+	gamma   materials.txt, g(x, u) -    (  ).
+	      lambda  g  u.
+	   solve_nonlinear (Nonlinear.h).
+*/
+template<typename T>
+class INonlinearFunctions
+{
+public:
+	virtual ~INonlinearFunctions() {}
+	virtual T f(T& x) = 0;
+	virtual T lambda(T& x, T& u) = 0;
+	virtual T dlambda(T& x, T& u) = 0;
+	virtual T gamma(T&, T&) { return 0; }
+	virtual T dgamma(T&, T&) { return 0; }
+	virtual std::string ToString() = 0;
+
+	//  ,   IInputFunctions: count  x   u  ,
+	//  value - ,  derivative -   u.
+	virtual void f(const T* x, T* value, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			T xi = x[i];
+			value[i] = f(xi);
+		}
+	}
+
+	virtual void lambda(const T* x, const T* u, T* value, T* derivative, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			T xi = x[i], ui = u[i];
+			value[i] = lambda(xi, ui);
+			derivative[i] = dlambda(xi, ui);
+		}
+	}
+
+	virtual void gamma(const T* x, const T* u, T* value, T* derivative, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			T xi = x[i], ui = u[i];
+			value[i] = gamma(xi, ui);
+			derivative[i] = dgamma(xi, ui);
+		}
+	}
 };
 
 #pragma region    
 
 //   ,  140
 template<typename T>
-class test1 : public IInputFunctions<T>
+class test1 : public InputFunctions<T, test1<T>>
 {
 public:
+	using InputFunctions<T, test1<T>>::f;
+	using InputFunctions<T, test1<T>>::lambda;
+
 	virtual T f(T& x)
 	{
 		if (x <= 2)
@@ -51,13 +161,26 @@ public:
 		else
 			return -(x - 3) * (x - 3) / 8 + 3.5;
 	}
+
+	T du(T& x)
+	{
+		if (x <= 2)
+			return 1;
+		else if (x <= 3)
+			return -(x - 3);
+		else
+			return -(x - 3) / 4;
+	}
 };
 
 //   ,  188
 template<typename T>
-class test2 : public IInputFunctions<T>
+class test2 : public InputFunctions<T, test2<T>>
 {
 public:
+	using InputFunctions<T, test2<T>>::f;
+	using InputFunctions<T, test2<T>>::lambda;
+
 	virtual T f(T& x)
 	{
 		if (x <= 1)
@@ -86,6 +209,14 @@ public:
 		else
 			return x * x - x + 8;
 	}
+
+	T du(T& x)
+	{
+		if (x <= 1)
+			return 3 * x * x + 7;
+		else
+			return 2 * x - 1;
+	}
 };
 
 #pragma endregion
\ No newline at end of file
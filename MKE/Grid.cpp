@@ -1,80 +1,324 @@
 #include "Grid.h"
-#include <fstream>
+#include "MappedFile.h"
+#include <charconv>
+#include <thread>
+#include <stdexcept>
 
-//    .      .
-// info.txt -     ,  , ,
-//    (  (2)   (3))
-//        .
-//    .
-//       .
-void input(std::string path, grid_in& out)
+//     ,   .
+//            .
+class TextReader
 {
-	std::ifstream info(path + "/info.txt");
+public:
+	//  .  required,   - ,  open  false.
+	bool open(const std::string& path, bool required = true)
+	{
+		name = path;
+		if (!file.open(path))
+		{
+			if (required)
+				throw new std::invalid_argument("Can not open file " + path);
+			return false;
+		}
+		begin = current = file.data();
+		end = begin + file.size();
+		return true;
+	}
 
-	info >> out.count_elements >> out.count_nodes >> out.count_materials;
-	info >> out.basis;
+	//   .
+	template<typename V>
+	V next()
+	{
+		V value;
+		current = parse(current, end, value);
+		return value;
+	}
 
-	if (out.count_elements + 1 != out.count_nodes)
-		throw new std::invalid_argument("Count nodes have to be equals count elements plus one. For example: 4 5 ...");
+	//  count   out.     ,
+	//    .        .
+	template<typename V>
+	void read_all(V* out, int count)
+	{
+		const size_t chunk_size = 1 << 20;
+		size_t length = end - current;
+		int chunks = length < chunk_size ? 1 : (int)std::thread::hardware_concurrency() * 4;
+		if (chunks <= 1)
+		{
+			for (int i = 0; i < count; i++)
+				out[i] = next<V>();
+			finish();
+			return;
+		}
 
-	out.elems.resize(out.count_elements);
-	out.nodes.resize(out.count_nodes);
+		//      ,    
+		std::vector<const char*> bounds(chunks + 1);
+		bounds[0] = current;
+		bounds[chunks] = end;
+		for (int c = 1; c < chunks; c++)
+		{
+			const char* p = current + length / chunks * c;
+			if (p < bounds[c - 1])
+				p = bounds[c - 1];
+			while (p < end && !space(*p))
+				p++;
+			bounds[c] = p;
+		}
+
+		//   -     ,  -    
+		std::vector<long long> first(chunks + 1, 0);
+		#pragma omp parallel for
+		for (int c = 0; c < chunks; c++)
+		{
+			long long tokens = 0;
+			for (const char* p = bounds[c]; p < bounds[c + 1]; p++)
+				if (!space(*p) && (p == bounds[c] || space(p[-1])))
+					tokens++;
+			first[c + 1] = tokens;
+		}
+		for (int c = 0; c < chunks; c++)
+			first[c + 1] += first[c];
+
+		if (first[chunks] != count)
+			error("expected " + std::to_string(count) + " numbers, found " + std::to_string(first[chunks]), end);
+
+		std::vector<std::string*> errors(chunks, nullptr);
+		#pragma omp parallel for
+		for (int c = 0; c < chunks; c++)
+		{
+			try
+			{
+				const char* p = bounds[c];
+				for (long long i = first[c]; i < first[c + 1]; i++)
+					p = parse(p, bounds[c + 1], out[i]);
+			}
+			catch (std::invalid_argument* e)
+			{
+				errors[c] = new std::string(e->what());
+				delete e;
+			}
+		}
+
+		//      
+		for (int c = 0; c < chunks; c++)
+			if (errors[c] != nullptr)
+			{
+				std::string message = *errors[c];
+				for (std::string* e : errors)
+					delete e;
+				throw new std::invalid_argument(message);
+			}
+		current = end;
+	}
+
+	// ,      ,  .
+	void finish()
+	{
+		while (current < end && space(*current))
+			current++;
+		if (current < end)
+			error("unexpected data after the last number", current);
+	}
+
+private:
+	MappedFile file;
+	std::string name;
+	const char* begin = nullptr;
+	const char* current = nullptr;
+	const char* end = nullptr;
+
+	static bool space(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+	}
+
+	[[noreturn]] void error(const std::string& message, const char* at)
+	{
+		throw new std::invalid_argument(name + ": " + message + " at byte " + std::to_string(at - begin));
+	}
+
+	//  ,   p,     .
+	template<typename V>
+	const char* parse(const char* p, const char* last, V& value)
+	{
+		while (p < last && space(*p))
+			p++;
+		if (p == last)
+			error("unexpected end of file", p);
+
+		// from_chars    ,   
+		const char* start = p;
+		if (*p == '+' && p + 1 < last && *(p + 1) != '-')
+			p++;
+
+		std::from_chars_result result = std::from_chars(p, last, value);
+		if (result.ec != std::errc() || (result.ptr < last && !space(*result.ptr)))
+			error("invalid number", start);
+		return result.ptr;
+	}
+};
+
+//  info.txt  conditions.txt.      - ,   read_all.
+static void input_info(std::string path, grid_in& out)
+{
+	TextReader info;
+	info.open(path + "/info.txt");
+
+	out.count_elements = info.next<int>();
+	out.count_nodes = info.next<int>();
+	out.count_materials = info.next<int>();
+	out.basis = info.next<int>();
+	if (out.count_materials < 1)
+		throw new std::invalid_argument("Count materials have to be positive");
 	out.materials.resize(out.count_materials);
 
-	int condleft, condright;
-	info >> condleft >> condright;
+	int condleft = info.next<int>(), condright = info.next<int>();
 	if (condleft < 1 || condleft > 3)
 		throw new std::invalid_argument("Left condition have to be in range [1, 3]");
 	if (condright < 1 || condright > 3)
 		throw new std::invalid_argument("RIght condition have to be in range [1, 3]");
+	info.finish();
 
 	out.r_cond = std::make_tuple(condleft, condright);
-	info.close();
 
 	//     .
-	std::ifstream conditions(path + "/conditions.txt");
-	out.conditions.resize(4);
+	TextReader conditions;
+	conditions.open(path + "/conditions.txt");
+	out.conditions.assign(4, 0);
 	int index = 0;
 
 	//      ,     .
 	if (condleft == 2)
-		conditions >> out.conditions[index++];
+		out.conditions[index++] = conditions.next<double>();
 	else if (condleft == 3)
 	{
-		conditions >> out.conditions[index++];
-		conditions >> out.conditions[index++];
+		out.conditions[index++] = conditions.next<double>();
+		out.conditions[index++] = conditions.next<double>();
 	}
 
 	if (condright == 2)
-		conditions >> out.conditions[index++];
+		out.conditions[index++] = conditions.next<double>();
 	else if (condright == 3)
 	{
-		conditions >> out.conditions[index++];
-		conditions >> out.conditions[index++];
+		out.conditions[index++] = conditions.next<double>();
+		out.conditions[index++] = conditions.next<double>();
 	}
 
 	if (condleft == 1)
-		conditions >> out.conditions[index++];
+		out.conditions[index++] = conditions.next<double>();
 
 	if (condright == 1)
-		conditions >> out.conditions[index++];
+		out.conditions[index++] = conditions.next<double>();
+	conditions.finish();
+}
 
-	conditions.close();
+//  materials.txt.     count_materials.
+static void input_materials(std::string path, grid_in& out)
+{
+	TextReader mat;
+	mat.open(path + "/materials.txt");
+	for (int i = 0; i < out.count_materials; i++)
+	{
+		double lambda = mat.next<double>();
+		double gamma = mat.next<double>();
+		out.materials[i] = std::make_tuple(lambda, gamma);
+	}
+	mat.finish();
+}
 
-	std::ifstream nodes(path + "/nodes.txt");
-	for (int i = 0; i < out.count_nodes; i++)
-		nodes >> out.nodes[i];
-	nodes.close();
+//  mesh.txt:  ,    
+// , ,  ,       .
+//    :      .
+static void input_segments(TextReader& file, grid_in& out, mesh_spec& mesh)
+{
+	int count = file.next<int>();
+	if (count < 1)
+		throw new std::invalid_argument("Count segments have to be positive");
+	mesh.segments.resize(count);
+	mesh.count_elements = 0;
 
-	std::ifstream elements(path + "/elements.txt");
-	for (int i = 0; i < out.count_elements; i++)
-		elements >> out.elems[i];
+	for (int i = 0; i < count; i++)
+	{
+		mesh_segment& s = mesh.segments[i];
+		s.begin = file.next<double>();
+		s.end = file.next<double>();
+		s.count = file.next<int>();
+		s.ratio = file.next<double>();
+		s.material = file.next<int>();
 
-	std::ifstream mat(path + "/materials.txt");
-	for (int i = 0; i < out.count_materials; i++)
+		if (s.end <= s.begin || s.count < 1 || s.ratio <= 0)
+			throw new std::invalid_argument("Segment have to be nonempty interval with positive count of elements and ratio");
+		if (s.material < 0 || s.material >= out.count_materials)
+			throw new std::invalid_argument("Segment material have to be in range [0, count materials)");
+		if (i > 0 && s.begin != mesh.segments[i - 1].end)
+			throw new std::invalid_argument("Segments have to follow each other without gaps");
+
+		mesh.count_elements += s.count;
+	}
+	file.finish();
+
+	out.count_elements = mesh.count_elements;
+	out.count_nodes = mesh.count_elements + 1;
+}
+
+//    .      .
+// info.txt -     ,  , ,
+//    (  (2)   (3))
+//        .
+//    .
+//       .
+//     mesh.txt,      ,
+//  nodes.txt  elements.txt  .      info.txt
+//   .
+//         ,
+// nodes.txt  elements.txt   -  .
+//             .
+void input(std::string path, grid_in& out)
+{
+	input_info(path, out);
+	input_materials(path, out);
+
+	TextReader segments;
+	if (segments.open(path + "/mesh.txt", false))
 	{
-		double lambda, gamma;
-		mat >> lambda >> gamma;
-		out.materials[i] = std::make_tuple(lambda, gamma);
+		mesh_spec mesh;
+		input_segments(segments, out, mesh);
+
+		out.nodes.resize(out.count_nodes);
+		out.elems.resize(out.count_elements);
+		mesh.for_each_element([&](int k, double x0, double x1, int material)
+		{
+			out.nodes[k] = x0;
+			out.nodes[k + 1] = x1;
+			out.elems[k] = material;
+		});
+		return;
 	}
-}
\ No newline at end of file
+
+	if (out.count_elements < 1 || out.count_elements + 1 != out.count_nodes)
+		throw new std::invalid_argument("Count nodes have to be equals count elements plus one. For example: 4 5 ...");
+
+	out.elems.resize(out.count_elements);
+	out.nodes.resize(out.count_nodes);
+
+	TextReader nodes;
+	nodes.open(path + "/nodes.txt");
+	nodes.read_all(out.nodes.data(), out.count_nodes);
+
+	TextReader elements;
+	elements.open(path + "/elements.txt");
+	elements.read_all(out.elems.data(), out.count_elements);
+
+	for (int i = 0; i < out.count_elements; i++)
+		if (out.elems[i] < 0 || out.elems[i] >= out.count_materials)
+			throw new std::invalid_argument("Material of element " + std::to_string(i) + " have to be in range [0, count materials)");
+}
+
+void input_mesh(std::string path, grid_in& out, mesh_spec& mesh)
+{
+	input_info(path, out);
+	input_materials(path, out);
+
+	TextReader segments;
+	if (!segments.open(path + "/mesh.txt", false))
+		throw new std::invalid_argument("File mesh.txt not found");
+	input_segments(segments, out, mesh);
+}
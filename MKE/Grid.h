@@ -2,6 +2,7 @@
 #include <vector>
 #include <string>
 #include <tuple>
+#include <cmath>
 
 struct grid_in
 {
@@ -23,4 +24,76 @@ struct grid_in
 	std::vector<std::tuple<double, double>> materials;
 };
 
-void input(std::string path, grid_in& out);
\ No newline at end of file
+//  :  [begin, end],   count   material.
+//       ratio  (1 -  ).
+struct mesh_segment
+{
+	double begin, end;
+	int count;
+	double ratio;
+	int material;
+};
+
+// ,   ( mesh.txt).
+//   ,    ,        .
+struct mesh_spec
+{
+	std::vector<mesh_segment> segments;
+	int count_elements = 0;
+
+	//    ,  k-  
+	// element(k,  ,  ,  ).
+	template<typename F>
+	void for_each_element(F element)
+	{
+		int k = 0;
+		for (mesh_segment& s : segments)
+		{
+			double length = s.end - s.begin;
+			double last = s.ratio == 1 ? s.count : std::pow(s.ratio, s.count) - 1;
+			double power = 1, left = s.begin;
+
+			for (int j = 1; j <= s.count; j++)
+			{
+				power *= s.ratio;
+				double right = j == s.count ? s.end
+					: s.begin + length * (s.ratio == 1 ? j : power - 1) / last;
+				element(k++, left, right, s.material);
+				left = right;
+			}
+		}
+	}
+};
+
+void input(std::string path, grid_in& out);
+
+//  ,      mesh.txt.
+//     out  ,       mesh,
+//    info.txt.
+void input_mesh(std::string path, grid_in& out, mesh_spec& mesh);
+
+//   [x0, x1]   basis.
+//      ,   
+//     .
+template<typename T>
+void element_nodes(T x0, T x1, int basis, T* x)
+{
+	T h = (x1 - x0) / basis;
+
+	//   
+	for (int i = 0; i <= basis; i++)
+		x[i] = x0 + i * h;
+
+	if (x[0] == 0) x[0] += 1e-14;
+	else x[0] += pow(10, int(log10(x[0])) - 14);
+
+	if (x[basis] == 0) x[basis] -= 1e-14;
+	else x[basis] -= pow(10, int(log10(x[0])) - 14);
+}
+
+//  k- .
+template<typename T>
+void element_nodes(grid_in& in, int k, T* x)
+{
+	element_nodes<T>(in.nodes[k], in.nodes[k + 1], in.basis, x);
+}
\ No newline at end of file
@@ -20,6 +20,7 @@ class ILocalMatrix
 {
 public:
     ILocalMatrix<T>() {}
+    virtual ~ILocalMatrix() {}
     //  
     virtual std::vector<std::vector<T>>* get_matrix(std::vector<T>& x, std::tuple<double, double>& mat) = 0;
 };
@@ -28,6 +29,7 @@ template<typename T>
 class ILocalVector
 {
 public:
+    virtual ~ILocalVector() {}
     //  
     virtual std::vector<T>* get_vector(std::vector<T>& x) = 0;
 };
@@ -1,4 +1,6 @@
 #include "Matrix.cpp"
+#include "Solution.h"
+#include "Norms.h"
 #include <iostream>
 #include <fstream>
 #include <iomanip>
@@ -16,62 +18,42 @@ void run(std::vector<double>& q, grid_in& in)
 
 	Matrix<double> m;
 	m.solve_FEM(in, Functions, q);
-	m.~Matrix();
 }
 
-//      ( ,    )
-double get_solve(double x, std::vector<double>& q, grid_in& in)
+//      ( ,    ).
+// SolutionEvaluator      ( O(N))     .
+double get_solve(double x, const SolutionEvaluator<double>& solution)
 {
-	int k = 0;
-	for (int i = 0; i < in.count_nodes; i++)
-		if (x >= in.nodes[i])
-			k = i;
-
-	//  k   
-	//      
-	if (in.basis == 2)
-	{
-		double ksi = (x - in.nodes[k]) / (in.nodes[k + 1] - in.nodes[k]);
-		double fi1 = 2 * (ksi - 0.5)*(ksi - 1),
-			fi2 = -4 * ksi*(ksi - 1),
-			fi3 = 2*ksi*(ksi - 0.5);
-		return fi1 * q[2*k] + fi2 * q[2*k + 1] + fi3 * q[2*k + 2];
-	}
-	else if (in.basis == 3)
-	{
-		double ksi = (x - in.nodes[k]) / (in.nodes[k + 1] - in.nodes[k]);
-		double fi1 = -4.5 * (ksi - 0.3333333333333333333) * (ksi - 1.) * (ksi - 0.66666666666666666666666),
-			fi2 = 13.5 * ksi * (ksi - 0.6666666666666666666)*(ksi - 1.),
-			fi3 = -13.5 * ksi * (ksi - 0.333333333333333333333) * (ksi - 1.),
-			fi4 = 4.5 * ksi * (ksi - 0.3333333333333333333333) * (ksi - 0.666666666666666666666);
-		return fi1 * q[3*k] + fi2 * q[3 * k + 1] + fi3 * q[3 * k + 2] + fi4 * q[3 * k + 3];
-	}
-	else
-		throw new std::invalid_argument("Invalid basis in input");
+	return solution(x);
 }
 
 //    
-void print_solve_accuracy(std::vector<double>& w, std::vector<double>& q, grid_in& in, std::ostream& out)
+void print_solve_accuracy(std::vector<double>& w, const SolutionEvaluator<double>& solution, std::ostream& out)
 {
 	caseName Functions;
+	std::vector<double> u;
+	solution.evaluate(w, u);
 	for (int i = 0; i < w.size(); i++)
-		out << get_solve(w[i], q, in) - Functions.u(w[i]) << " ";
+		out << u[i] - Functions.u(w[i]) << " ";
 	out << std::endl;
 }
 
 //     
-void get_solve_accuracy(std::vector<double>& w, std::vector<double>& q, grid_in& in, std::string path, std::ostream& out, std::vector<double>& result)
+void get_solve_accuracy(std::vector<double>& w, const SolutionEvaluator<double>& solution, std::vector<double>& result)
 {
 	caseName Functions;
+	solution.evaluate(w, result);
 	for (int i = 0; i < w.size(); i++)
-		result[i] = get_solve(w[i], q, in) - Functions.u(w[i]);
+		result[i] -= Functions.u(w[i]);
 }
 
 //    
-void print_solve_nodes(std::vector<double>& w, std::vector<double>& q, grid_in& in, std::ostream& out)
+void print_solve_nodes(std::vector<double>& w, const SolutionEvaluator<double>& solution, std::ostream& out)
 {
+	std::vector<double> u;
+	solution.evaluate(w, u);
 	for (int i = 0; i < w.size(); i++)
-		out << get_solve(w[i], q, in) << " ";
+		out << u[i] << " ";
 	out << std::endl;
 }
 
@@ -86,7 +68,8 @@ int main()
 	
 	setlocale(LC_ALL, "Russian");
 	std::cout << "1)  " << std::endl
-			  << "2)       " << std::endl;
+			  << "2)       " << std::endl
+			  << "3)    " << std::endl;
 
 	int command = 0;
 	std::cin >> command;
@@ -115,16 +98,31 @@ int main()
 			w.push_back(node);
 		}
 
+		SolutionEvaluator<double> solution(in, q);
 		std::cout << "   :" << std::endl;
-		print_solve_accuracy(w, q, in, std::cout);
+		print_solve_accuracy(w, solution, std::cout);
 
 		std::cout << "   :" << std::endl;
-		print_solve_nodes(w, q, in, std::cout);
+		print_solve_nodes(w, solution, std::cout);
 
 		q.clear();
 		w.clear();
 		break;
 	}
+	case 3:
+	{
+		int order = 0;
+		std::cout << "      (0 -  ): ";
+		std::cin >> order;
+
+		caseName Functions;
+		ErrorNorms<double> norms;
+		error_norms(in, q, Functions, norms, order);
+		std::cout << "L2: " << norms.L2 << std::endl
+				  << "H1: " << norms.H1 << std::endl
+				  << ": " << norms.energy << std::endl;
+		break;
+	}
 	default:
 		std::cout << "  " << std::endl;
 	}
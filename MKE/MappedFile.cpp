@@ -0,0 +1,119 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		return false;
+	file = handle;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(handle, &size))
+	{
+		close();
+		return false;
+	}
+	length = (size_t)size.QuadPart;
+
+	//    ,     
+	if (length == 0)
+		return true;
+
+	mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	begin = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (begin == nullptr)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (begin != nullptr)
+		UnmapViewOfFile(begin);
+	if (mapping != nullptr)
+		CloseHandle(mapping);
+	if (file != nullptr)
+		CloseHandle(file);
+
+	begin = nullptr;
+	mapping = nullptr;
+	file = nullptr;
+	length = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+	file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(file, &info) != 0)
+	{
+		close();
+		return false;
+	}
+	length = (size_t)info.st_size;
+
+	//    ,     
+	if (length == 0)
+		return true;
+
+	void* view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file, 0);
+	if (view == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+	begin = (const char*)view;
+	madvise(view, length, MADV_SEQUENTIAL);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (begin != nullptr)
+		munmap((void*)begin, length);
+	if (file >= 0)
+		::close(file);
+
+	begin = nullptr;
+	file = -1;
+	length = 0;
+}
+
+#endif
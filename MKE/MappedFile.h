@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+/*
+	,      .
+	         .
+*/
+class MappedFile
+{
+public:
+	MappedFile() {}
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	//   path.  false,     .
+	bool open(const std::string& path);
+	void close();
+
+	const char* data() const { return begin; }
+	size_t size() const { return length; }
+
+private:
+	const char* begin = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#else
+	int file = -1;
+#endif
+};
@@ -1,8 +1,19 @@
+#pragma once
 #include <ostream>
 #include "Grid.h"
 #include "LocalMatrix.h"
+#include "Element.h"
+#include "BandMatrix.h"
+#include "DomainDecomposition.h"
+#include "Container.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
+#include <array>
+#include <cstring>
+#include <unordered_map>
 
 //     
 template<typename T>
@@ -14,19 +25,43 @@ private:
     std::vector<int> ia;
     //     .
     std::vector<T>& au = al;
+    // ,    .     1.
+    int basis = 0;
 
-
+    //        .
+    //        i  
+    // (E0, E1, c): u_i = c - E0 * u_left - E1 * u_right.
+    std::vector<T> interior;
+    // ,         .
+    std::vector<T> dirichlet_left, dirichlet_right;
+    // ,      (. prepare_FEM  ).
+    //   , forward_block  backward_block   ,    al, di, ia.
+    std::shared_ptr<ContainerReader> mapped;
+    const T* mapped_al = nullptr;
+    const T* mapped_di = nullptr;
+    const int* mapped_ia = nullptr;
+    //      .     ,
+    //  f         IInputFunctions.
+    static const int batch = 64;
     //     .
     //         .
-    void init(int count_elems, int basis, std::vector<T>& x)
+    //   :  k * basis + i (i = 1..basis) k- 
+    //  i  ,       al
+    //    .
+    void init(int count_elems, int basis)
     {
         int size = 0;
         size = basis * count_elems + 1;
-        x.resize(basis + 1);
 
         ia.resize(size + 1);
-        di.resize(size);
+        di.assign(size, 0);
         dim = size;
+        this->basis = basis;
+        mapped.reset();
+
+        ia[0] = 0;
+        for (int i = 0; i < size; i++)
+            ia[i + 1] = ia[i] + (i == 0 ? 0 : (i - 1) % basis + 1);
 
         //     .
         int count = 0;
@@ -64,7 +99,7 @@ private:
             int i1 = ia[i + 1];
 
             for (int j = ia[i], k = i1 - i0 < i ? i - (i1 - i0) : 0; j < i1; j++, k++)
-                elem -= al[j] * b[k];
+                elem -= al[j] * y[k];
 
             elem /= di[i];
             y[i] = elem;
@@ -73,101 +108,427 @@ private:
 
     //  
     //      solve_matrix(vector<T>, vector<T>)
+    //    L^T:  x[i]      ,
+    //     dim,   .
     void backward(std::vector<T>& x, const std::vector<T>& y)
     {
+        if (&x != &y)
+            x = y;
+
         for (int i = dim - 1; i >= 0; i--)
         {
-            T sum = 0;
-            T xi = x[i] = y[i] / di[i];
+            int i0 = ia[i];
+            int i1 = ia[i + 1];
+            T xi = x[i] /= di[i];
 
-            for (int j = dim - 1; j > i; j--)
-            {
-                int bias = ia[j + 1] - ia[j] - j + i;
-                if (bias >= 0)
-                    sum += al[ia[j] + bias] * y[j];
-            }
-            sum /= di[i];
-            x[i] -= sum;
+            for (int k = i0, j = i - (i1 - i0); k < i1; k++, j++)
+                x[j] -= al[k] * xi;
+        }
+    }
+
+    //   .
+    int profile_width() const
+    {
+        int p = 0;
+        for (int i = 0; i < dim; i++)
+            if (ia[i + 1] - ia[i] > p)
+                p = ia[i + 1] - ia[i];
+        return p;
+    }
+
+    //       ,    .
+    //        U (. solve_mixed).
+    template<typename U>
+    void to_band(BandMatrix<U>& band)
+    {
+        band.init(dim, profile_width());
+        for (int i = 0; i < dim; i++)
+        {
+            int i0 = ia[i];
+            int i1 = ia[i + 1];
+            band.di[i] = (U)di[i];
+
+            for (int k = i0, j = i - (i1 - i0); k < i1; k++, j++)
+                band.elem(i, j) = (U)al[k];
+        }
+    }
+
+    //  y = Ax   ( )  , p - 
+    //  . x  y   .    i -  i
+    // :  (j, i) ,    j   .
+    void multiply(const std::vector<T>& x, std::vector<T>& y, int p) const
+    {
+        y.resize(dim);
+        #pragma omp parallel for
+        for (int i = 0; i < dim; i++)
+        {
+            int i0 = ia[i];
+            int i1 = ia[i + 1];
+            int j1 = i + p < dim ? i + p : dim - 1;
+            T sum = di[i] * x[i];
+
+            for (int k = i0, j = i - (i1 - i0); k < i1; k++, j++)
+                sum += al[k] * x[j];
+            for (int j = i + 1; j <= j1; j++)
+                if (ia[j + 1] - ia[j] >= j - i)
+                    sum += al[ia[j + 1] - (j - i)] * x[j];
+            y[i] = sum;
         }
     }
 
     //   .
-    void global_matrix(grid_in& in, ILocalMatrix<T>& localMatrix, ILocalVector<T>& localVector, std::vector<T>& b)
+    //     ,     Element<T, P>.
+    void global_matrix(grid_in& in, IInputFunctions<T>& Functions, std::vector<T>& b)
     {
         //      
         //    .
         //       
         //     ,   , 
         //    ,    .
-        std::vector<T> x;
+        switch (in.basis)
+        {
+        case 1: global_matrix<1>(in, Functions, b); break;
+        case 2: global_matrix<2>(in, Functions, b); break;
+        case 3: global_matrix<3>(in, Functions, b); break;
+        case 4: global_matrix<4>(in, Functions, b); break;
+        case 5: global_matrix<5>(in, Functions, b); break;
+        case 6: global_matrix<6>(in, Functions, b); break;
+        case 7: global_matrix<7>(in, Functions, b); break;
+        case 8: global_matrix<8>(in, Functions, b); break;
+        default:
+            throw new std::invalid_argument("Invalid basis in input");
+        }
+    }
+
+    //       P.
+    //      :  ,  .
+    //       ,    di  b  ,
+    //         ,    
+    //       .
+    //     batch   :  
+    //     ,      .
+    template<int P>
+    void global_matrix(grid_in& in, IInputFunctions<T>& Functions, std::vector<T>& b)
+    {
+        typedef Element<T, P> element;
+        const int N = element::N;
+
+        //         .
+        init(in.count_elements, condensation ? 1 : P);
+        b.assign(this->dim, 0);
 
-        init(in.count_elements, in.basis, x);
-        b.resize(this->dim);
+        if (condensation)
+            interior.resize(in.count_elements * (P - 1) * 3);
+
+        //        ,  
+        //     (,  ).
+        std::vector<typename element::matrix_type> local;
+        std::vector<int> slot;
+        if (constant_materials)
+            local_cache<P>(in, local, slot);
+        //  ,   Functions.lambda    
+        int mismatch = in.count_elements;
 
         //   
+        for (int color = 0; color < 2; color++)
+        {
+            int count = (in.count_elements - color + 1) / 2;
+
+            #pragma omp parallel for
+            for (int c = 0; c < (count + batch - 1) / batch; c++)
+            {
+                // ,      n   
+                std::array<T, batch * N> x, lambda, f;
+                std::array<T, batch> h, gamma;
+                int first = c * batch;
+                int n = count - first < batch ? count - first : batch;
+
+                for (int e = 0; e < n; e++)
+                {
+                    int k = color + 2 * (first + e);
+                    h[e] = in.nodes[k + 1] - in.nodes[k];
+                    gamma[e] = std::get<1>(in.materials[in.elems[k]]);
+                    element_nodes(in, k, &x[e * N]);
+                }
+
+                Functions.lambda(x.data(), lambda.data(), n * N);
+                Functions.f(x.data(), f.data(), n * N);
+
+                //       Functions.lambda   
+                if (constant_materials)
+                    for (int e = 0; e < n; e++)
+                    {
+                        int k = color + 2 * (first + e);
+                        T expected = T(std::get<0>(in.materials[in.elems[k]]));
+                        for (int i = 0; i < N; i++)
+                            if (!(std::fabs(lambda[e * N + i] - expected) <= 1e-10 * std::fabs(expected)))
+                            {
+                                #pragma omp critical
+                                if (k < mismatch)
+                                    mismatch = k;
+                            }
+                    }
+
+                for (int e = 0; e < n; e++)
+                {
+                    int k = color + 2 * (first + e);
+                    typename element::vector_type l_v;
+                    typename element::matrix_type l_m;
+
+                    if (constant_materials)
+                        l_m = local[slot[k]];
+                    else
+                        element::matrix(&lambda[e * N], gamma[e], h[e], l_m);
+                    element::vector(&f[e * N], h[e], l_v);
+
+                    if (condensation)
+                    {
+                        //   ,      
+                        std::array<std::array<T, 2>, 2> schur;
+                        std::array<T, 2> schur_b;
+                        condense<N>(l_m, l_v, k, schur, schur_b);
+                        insert_local<2>(schur, k);
+                        b[k] += schur_b[0];
+                        b[k + 1] += schur_b[1];
+                        continue;
+                    }
+
+                    //     
+                    insert_local<N>(l_m, k);
+
+                    //     
+                    for (int i = 0; i < N; i++)
+                        b[k * P + i] += l_v[i];
+                }
+            }
+        }
+
+        if (mismatch < in.count_elements)
+            throw new std::invalid_argument("constant_materials: Functions.lambda differs from materials.txt on element "
+                + std::to_string(mismatch));
+    }
+
+    //            materials.txt.
+    // local -  , slot[k] -   k-   local.
+    //  -     ,      44 :
+    // ,     ,   .
+    template<int P>
+    void local_cache(grid_in& in, std::vector<std::array<std::array<T, P + 1>, P + 1>>& local, std::vector<int>& slot)
+    {
+        std::vector<std::unordered_map<unsigned long long, int>> cache(in.count_materials);
+        slot.resize(in.count_elements);
+
         for (int k = 0; k < in.count_elements; k++)
         {
             int num_material = in.elems[k];
-            T x0 = in.nodes[k], h = (in.nodes[k + 1] - in.nodes[k]) / in.basis;
+            double h = in.nodes[k + 1] - in.nodes[k];
+            unsigned long long key;
+            std::memcpy(&key, &h, sizeof(key));
+            key >>= 8;
 
-            //   
-            for (int i = 0; i <= in.basis; i++)
-                x[i] = x0 + i * h;
+            auto found = cache[num_material].find(key);
+            if (found != cache[num_material].end())
+            {
+                slot[k] = found->second;
+                continue;
+            }
 
-            if (x[0] == 0) x[0] += 1e-14;
-            else x[0] += pow(10, int(log10(x[0])) - 14);
+            slot[k] = local.size();
+            cache[num_material][key] = slot[k];
+            local.emplace_back();
+            Element<T, P>::matrix(T(std::get<0>(in.materials[num_material])),
+                T(std::get<1>(in.materials[num_material])), T(h), local.back());
+        }
+    }
 
-            if (x[in.basis] == 0) x[in.basis] -= 1e-14;
-            else x[in.basis] -= pow(10, int(log10(x[0])) - 14);
+    //      col  B  count  .
+    void global_vector(grid_in& in, IInputFunctions<T>& Functions, std::vector<T>& B, int col, int count)
+    {
+        switch (in.basis)
+        {
+        case 1: global_vector<1>(in, Functions, B, col, count); break;
+        case 2: global_vector<2>(in, Functions, B, col, count); break;
+        case 3: global_vector<3>(in, Functions, B, col, count); break;
+        case 4: global_vector<4>(in, Functions, B, col, count); break;
+        case 5: global_vector<5>(in, Functions, B, col, count); break;
+        case 6: global_vector<6>(in, Functions, B, col, count); break;
+        case 7: global_vector<7>(in, Functions, B, col, count); break;
+        case 8: global_vector<8>(in, Functions, B, col, count); break;
+        default:
+            throw new std::invalid_argument("Invalid basis in input");
+        }
+    }
+
+    //       P.
+    //       ,    global_matrix.
+    template<int P>
+    void global_vector(grid_in& in, IInputFunctions<T>& Functions, std::vector<T>& B, int col, int count)
+    {
+        typedef Element<T, P> element;
+        const int N = element::N;
+
+        B.resize(dim * count);
+        for (int i = 0; i < dim; i++)
+            B[i * count + col] = 0;
+
+        for (int color = 0; color < 2; color++)
+        {
+            int elements = (in.count_elements - color + 1) / 2;
+
+            #pragma omp parallel for
+            for (int c = 0; c < (elements + batch - 1) / batch; c++)
+            {
+                std::array<T, batch * N> x, f;
+                std::array<T, batch> h;
+                int first = c * batch;
+                int n = elements - first < batch ? elements - first : batch;
+
+                for (int e = 0; e < n; e++)
+                {
+                    int k = color + 2 * (first + e);
+                    h[e] = in.nodes[k + 1] - in.nodes[k];
+                    element_nodes(in, k, &x[e * N]);
+                }
+
+                Functions.f(x.data(), f.data(), n * N);
+
+                for (int e = 0; e < n; e++)
+                {
+                    int k = color + 2 * (first + e);
+                    typename element::vector_type l_v;
+
+                    element::vector(&f[e * N], h[e], l_v);
+                    for (int i = 0; i < N; i++)
+                        B[(k * P + i) * count + col] += l_v[i];
+                }
+            }
+        }
+    }
+
+    //   k-   N .
+    //   1..N-2     , 
+    //  : S = A_bb - A_bi A_ii^-1 A_ib, g = b_b - A_bi A_ii^-1 b_i.
+    // A_ii^-1 A_ib  A_ii^-1 b_i    .
+    template<int N>
+    void condense(const std::array<std::array<T, N>, N>& l_m, const std::array<T, N>& l_v, int k,
+        std::array<std::array<T, 2>, 2>& schur, std::array<T, 2>& schur_b)
+    {
+        const int m = N - 2;
+        const int last = N - 1;
+        std::array<T, m * m> cond_a;
+        std::array<T, m * 3> cond_r;
+
+        for (int i = 0; i < m; i++)
+        {
+            for (int j = 0; j < m; j++)
+                cond_a[i * m + j] = l_m[i + 1][j + 1];
+
+            cond_r[i * 3] = l_m[i + 1][0];
+            cond_r[i * 3 + 1] = l_m[i + 1][last];
+            cond_r[i * 3 + 2] = l_v[i + 1];
+        }
+
+        //      , A_ii    
+        for (int i = 0; i < m; i++)
+            for (int r = i + 1; r < m; r++)
+            {
+                T c = cond_a[r * m + i] / cond_a[i * m + i];
+                for (int j = i; j < m; j++)
+                    cond_a[r * m + j] -= c * cond_a[i * m + j];
+                for (int j = 0; j < 3; j++)
+                    cond_r[r * 3 + j] -= c * cond_r[i * 3 + j];
+            }
+
+        for (int i = m - 1; i >= 0; i--)
+            for (int j = 0; j < 3; j++)
+            {
+                T sum = cond_r[i * 3 + j];
+                for (int c = i + 1; c < m; c++)
+                    sum -= cond_a[i * m + c] * cond_r[c * 3 + j];
+                cond_r[i * 3 + j] = sum / cond_a[i * m + i];
+            }
 
-            //     
-            std::vector<std::vector<T>>* l_m = localMatrix.get_matrix(x, in.materials[num_material]);
-            insert_local(*l_m, k);
+        schur[0][0] = l_m[0][0];
+        schur[1][0] = l_m[last][0];
+        schur[1][1] = l_m[last][last];
+        schur_b[0] = l_v[0];
+        schur_b[1] = l_v[last];
 
-            //     
-            std::vector<T>* l_v = localVector.get_vector(x);
-            int size = in.basis + 1;
-            for (int i = 0; i < size; i++)
-                b[k * in.basis + i] += l_v->at(i);
+        for (int i = 0; i < m; i++)
+        {
+            schur[0][0] -= l_m[0][i + 1] * cond_r[i * 3];
+            schur[1][0] -= l_m[last][i + 1] * cond_r[i * 3];
+            schur[1][1] -= l_m[last][i + 1] * cond_r[i * 3 + 1];
+            schur_b[0] -= l_m[0][i + 1] * cond_r[i * 3 + 2];
+            schur_b[1] -= l_m[last][i + 1] * cond_r[i * 3 + 2];
         }
+        schur[0][1] = schur[1][0];
+
+        std::copy(cond_r.begin(), cond_r.end(), interior.begin() + k * m * 3);
+    }
+
+    //         .
+    //  ,    .
+    void recover(grid_in& in, std::vector<T>& q)
+    {
+        //      , q   ( interior )
+        if (in.basis == 1)
+            return;
+
+        int m = in.basis - 1;
+        std::vector<T> full(in.basis * in.count_elements + 1);
+
+        #pragma omp parallel for
+        for (int k = 0; k < in.count_elements; k++)
+        {
+            T left = q[k], right = q[k + 1];
+            const T* e = interior.data() + (size_t)k * m * 3;
+
+            full[k * in.basis] = left;
+            for (int i = 0; i < m; i++)
+                full[k * in.basis + i + 1] = e[i * 3 + 2] - e[i * 3] * left - e[i * 3 + 1] * right;
+        }
+        full[in.basis * in.count_elements] = q[in.count_elements];
+
+        q.swap(full);
     }
 
     //     .
-    void conditions(grid_in& in, std::vector<double>& b)
+    //      conditions_rhs,    .
+    //          ,
+    //           .
+    void conditions(grid_in& in, std::vector<T>& b)
     {
         int first_border = std::get<0>(in.r_cond);
         int second_border = std::get<1>(in.r_cond);
         //        .
         int index = 0;
 
-        //      (),   ().
         if (first_border == 2)
-            b[0] += in.conditions[index++];
+            index++;
         else if (first_border == 3)
         {
-            this->di[0] += in.conditions[index++];  // beta
-            b[0] += in.conditions[index++];         // ubeta
+            this->di[0] += in.conditions[index];  // beta
+            index += 2;
         }
 
-        //       
         if (second_border == 2)
-            b[dim - 1] += in.conditions[index++];
+            index++;
         else if (second_border == 3)
         {
-            double beta = in.conditions[index++];
-            this->di[dim - 1] += beta;
-            b[dim - 1] += beta * in.conditions[index++];
+            this->di[dim - 1] += in.conditions[index];  // beta
+            index += 2;
         }
 
         if (first_border == 1)
         {
             //   ,    
             this->di[0] = 1;
-            b[0] = in.conditions[index++];
+            dirichlet_left.resize(basis);
 
-            for (int i = 0; i < in.basis; i++)
+            for (int i = 0; i < basis; i++)
             {
-                b[i + 1] += -this->al[this->ia[i + 1]] * b[0];
+                dirichlet_left[i] = this->al[this->ia[i + 1]];
                 //    ,    n 
                 this->al[this->ia[i + 1]] = 0;
             }
@@ -176,48 +537,268 @@ private:
         if (second_border == 1)
         {
             this->di[dim - 1] = 1;
-            b[dim - 1] = in.conditions[index];
+            dirichlet_right.resize(basis);
 
             //     
-            for (int i = 0; i < in.basis; i++)
-                b[dim - i - 2] += -this->al[this->ia[dim - 1] + in.basis - 1 - i] * b[dim - 1];
+            for (int i = 0; i < basis; i++)
+                dirichlet_right[i] = this->al[this->ia[dim - 1] + basis - 1 - i];
 
-            this->ia[dim] -= in.basis;
+            this->ia[dim] -= basis;
         }
+
+        conditions_rhs(in, b, 0, 1);
     }
 
-    //        k-  .
-    void insert_local(std::vector<std::vector<T>>& l_m, int k)
+    //      .
+    // b  count    (b[i * count + col]),   col.
+    //       conditions.
+    void conditions_rhs(grid_in& in, std::vector<T>& b, int col, int count)
     {
-        //   al    .
-        static int stop = 0;
+        int first_border = std::get<0>(in.r_cond);
+        int second_border = std::get<1>(in.r_cond);
+        int index = 0;
+        T& first = b[col];
+        T& last = b[(dim - 1) * count + col];
 
-        //   .
-        int size = l_m.size();
+        //      (),   ().
+        if (first_border == 2)
+            first += in.conditions[index++];
+        else if (first_border == 3)
+        {
+            index++;                                // beta
+            first += in.conditions[index++];        // ubeta
+        }
 
-        for (int i = 0; i < size; i++)
+        //       
+        if (second_border == 2)
+            last += in.conditions[index++];
+        else if (second_border == 3)
+        {
+            double beta = in.conditions[index++];
+            last += beta * in.conditions[index++];
+        }
+
+        if (first_border == 1)
+        {
+            first = in.conditions[index++];
+            for (int i = 0; i < basis; i++)
+                b[(i + 1) * count + col] += -dirichlet_left[i] * first;
+        }
+
+        if (second_border == 1)
         {
-            if (k == 0)
+            last = in.conditions[index];
+            for (int i = 0; i < basis; i++)
+                b[(dim - i - 2) * count + col] += -dirichlet_right[i] * last;
+        }
+    }
+
+    //     .   ,
+    //     ,    .
+    void attach(std::shared_ptr<ContainerReader> file)
+    {
+        const container_header& header = file->info();
+        size_t count;
+
+        al.clear();
+        di.clear();
+        ia.clear();
+        dim = header.dim;
+        basis = header.factor_basis;
+
+        mapped_ia = file->section<int>(section_ia, count);
+        mapped_di = file->section<T>(section_di, count);
+        mapped_al = file->section<T>(section_al, count);
+        const T* left = file->section<T>(section_dirichlet_left, count);
+        dirichlet_left.assign(left, left + count);
+        const T* right = file->section<T>(section_dirichlet_right, count);
+        dirichlet_right.assign(right, right + count);
+        mapped = file;
+    }
+
+    //  :     .
+    void factor_arrays(const T*& l, const T*& d, const int*& profile)
+    {
+        if (mapped)
+        {
+            l = mapped_al;
+            d = mapped_di;
+            profile = mapped_ia;
+        }
+        else
+        {
+            l = this->al.data();
+            d = this->di.data();
+            profile = this->ia.data();
+        }
+    }
+
+    //     N     k-  .
+    //    al   k,     init.
+    template<int N>
+    void insert_local(const std::array<std::array<T, N>, N>& l_m, int k)
+    {
+        int stop = k * (N * (N - 1) / 2);
+
+        for (int i = 0; i < N; i++)
+        {
+            di[k * (N - 1) + i] += l_m[i][i];
+
+            for (int j = 0; j < i; j++)
+                al[stop++] = l_m[i][j];
+        }
+    }
+
+
+    //    Ax = b   , b   -  q.
+    //     float    , 
+    //   T   ,     T  .
+    //  ,        T:
+    // |b - Ax| <= (2p + 2) * eps * (|A| |x| + |b|)   .
+    //     ,    
+    //           
+    //  max_iterations,       T.
+    void solve_mixed(std::vector<T>& q)
+    {
+        const int max_iterations = 10;
+        const T eps = std::numeric_limits<T>::epsilon();
+        const int p = profile_width();
+        refinement_iterations = 0;
+        refinement_fallback = false;
+
+        //   -     
+        T norm_a;
+        {
+            std::vector<T> row(dim, 0);
+            for (int i = 0; i < dim; i++)
             {
-                ia[i + 1] = ia[i] + i;
-                di[i] += l_m[i][i];
+                int i0 = ia[i];
+                int i1 = ia[i + 1];
+                row[i] += std::fabs(di[i]);
+                for (int k = i0, j = i - (i1 - i0); k < i1; k++, j++)
+                {
+                    T a = std::fabs(al[k]);
+                    row[i] += a;
+                    row[j] += a;
+                }
             }
-            else
+            norm_a = *std::max_element(row.begin(), row.end());
+        }
+
+        //     q  
+        const std::vector<T>& b = q;
+        std::vector<T> r(q), x(dim, 0);
+        T norm_b = 0;
+        for (int i = 0; i < dim; i++)
+            norm_b = std::max(norm_b, std::fabs(b[i]));
+
+        BandMatrix<float> low;
+        to_band(low);
+        std::vector<float> d(dim);
+
+        bool converged = norm_b == 0;
+        try
+        {
+            low.factorization();
+            //     ,    ,
+            //      float
+            T scale = norm_b;
+            for (int iteration = 0; iteration < max_iterations && !converged; iteration++)
             {
-                //      ,    .
-                if (i != 0)
-                    ia[k * size + i - k + 1] = ia[k * size + i - k] + i;
+                for (int i = 0; i < dim; i++)
+                    d[i] = (float)(r[i] / scale);
+                low.solve(d, d);
+
+                T norm_x = 0;
+                for (int i = 0; i < dim; i++)
+                {
+                    x[i] += scale * d[i];
+                    norm_x = std::max(norm_x, std::fabs(x[i]));
+                }
+                refinement_iterations++;
 
-                di[k * size + i - k] += l_m[i][i];
+                multiply(x, r, p);
+                T residual = 0;
+                for (int i = 0; i < dim; i++)
+                {
+                    r[i] = b[i] - r[i];
+                    residual = std::max(residual, std::fabs(r[i]));
+                }
+
+                if (!std::isfinite(residual))
+                    break;
+                //  ,       
+                T target = (2 * p + 2) * eps * (norm_a * norm_x + norm_b);
+                if (residual <= target)
+                {
+                    converged = true;
+                    break;
+                }
+                //       rate ~ eps_float * cond(A) .
+                //     target     ,
+                //    -      T
+                T rate = residual / scale;
+                if (!(rate < T(0.5)) || iteration + 1 + std::log(target / residual) / std::log(rate) > max_iterations)
+                    break;
+                scale = residual;
             }
+        }
+        catch (std::invalid_argument* e)
+        {
+            delete e;
+        }
 
-            for (int j = 0; j < i; j++)
-                al[stop++] = l_m[i][j];
+        if (converged)
+        {
+            q.swap(x);
+            return;
         }
-    }
 
+        //   float      ,     T
+        low = BandMatrix<float>();
+        std::vector<T>().swap(r);
+        std::vector<T>().swap(x);
+        std::vector<float>().swap(d);
+        refinement_fallback = true;
+        BandMatrix<T> band;
+        to_band(band);
+        band.factorization();
+        band.solve(q, q);
+    }
 
 public:
+    //     .
+    //       (count_elements + 1 ),
+    //      .
+    bool condensation = false;
+
+    //       (. solve_dd).
+    //  1    .
+    int domains = 1;
+
+    //           materials.txt.
+    //           ,
+    //          .
+    //   -   Functions.f  .
+    // Functions.lambda    :      
+    //  (   1e-10)      ,
+    //    invalid_argument     .
+    bool constant_materials = false;
+
+    //    solve_FEM:     float,
+    //     x += A_float^-1 (b - A x),    T
+    //    .    :  ,  
+    //   T   ,   ,    
+    //    ,       T   .
+    //        float  ,  
+    //    T.  (domains)     .
+    bool mixed_precision = false;
+
+    //   solve_FEM   :   
+    //       T.
+    int refinement_iterations = 0;
+    bool refinement_fallback = false;
+
     ~Matrix()
     {
         al.clear();
@@ -305,6 +886,141 @@ public:
         backward(x, x);
     }
 
+    //     count  ,  : B[i * count + c].
+    //         .
+    void forward_block(std::vector<T>& B, int count)
+    {
+        const T *al, *di;
+        const int* ia;
+        factor_arrays(al, di, ia);
+
+        for (int i = 0; i < dim; i++)
+        {
+            int i0 = ia[i];
+            int i1 = ia[i + 1];
+            T* bi = &B[i * count];
+
+            for (int k = i0, j = i - (i1 - i0); k < i1; k++, j++)
+            {
+                T a = al[k];
+                const T* bj = &B[j * count];
+                for (int c = 0; c < count; c++)
+                    bi[c] -= a * bj[c];
+            }
+
+            for (int c = 0; c < count; c++)
+                bi[c] /= di[i];
+        }
+    }
+
+    //     count  ,  .
+    void backward_block(std::vector<T>& B, int count)
+    {
+        const T *al, *di;
+        const int* ia;
+        factor_arrays(al, di, ia);
+
+        for (int i = dim - 1; i >= 0; i--)
+        {
+            int i0 = ia[i];
+            int i1 = ia[i + 1];
+            T* bi = &B[i * count];
+
+            for (int c = 0; c < count; c++)
+                bi[c] /= di[i];
+
+            for (int k = i0, j = i - (i1 - i0); k < i1; k++, j++)
+            {
+                T a = al[k];
+                T* bj = &B[j * count];
+                for (int c = 0; c < count; c++)
+                    bj[c] -= a * bi[c];
+            }
+        }
+    }
+
+    //           
+    //    b,  .    (. Multigrid.h).
+    //     .
+    void assemble_band(grid_in& in, IInputFunctions<T>& Functions, BandMatrix<T>& band, std::vector<T>& b)
+    {
+        bool condense = condensation;
+        condensation = false;
+        global_matrix(in, Functions, b);
+        condensation = condense;
+        conditions(in, b);
+        to_band(band);
+    }
+
+    //    ,        .
+    //      LLT     
+    //    : rhs_FEM + solve_block.
+    //     .
+    void prepare_FEM(grid_in& in, IInputFunctions<T>& Functions)
+    {
+        std::vector<T> b;
+        bool condense = condensation;
+        condensation = false;
+        global_matrix(in, Functions, b);
+        condensation = condense;
+        conditions(in, b);
+        factorization(*this);
+    }
+
+    //  ,  prepare_FEM,       container (. Container.h).
+    //     path.     ,  
+    //     ,      (   
+    //   )  constant_materials -     
+    // ,    .   -    .
+    //       .
+    void prepare_FEM(std::string path, std::string container, IInputFunctions<T>& Functions, grid_in& in)
+    {
+        uint64_t grid = grid_hash(path);
+        uint32_t flags = constant_materials ? factor_constant_materials : 0;
+        uint64_t factor;
+
+        {
+            std::shared_ptr<ContainerReader> file = std::make_shared<ContainerReader>();
+            bool cached = file->open(container) && file->info().grid_hash == grid;
+            if (cached)
+                file->grid(in);
+            else
+                input(path, in);
+
+            //        materials.txt     grid
+            uint64_t lambda = constant_materials ? 0 : lambda_hash(in, Functions);
+            factor = factor_hash(grid, Functions.ToString(), lambda, sizeof(T), flags);
+            if (cached && file->info().factor_hash == factor && file->info().factor_flags == flags && file->has_factor<T>())
+            {
+                attach(file);
+                return;
+            }
+        }
+
+        prepare_FEM(in, Functions);
+
+        ContainerWriter writer(in, grid);
+        writer.factor(factor, flags, dim, basis, ia, di, al, dirichlet_left, dirichlet_right);
+        writer.write(container);
+    }
+
+    //      Functions   col  B  count  .
+    // B  : B[i * count + col],   dim * count.
+    //     in,        prepare_FEM.
+    void rhs_FEM(grid_in& in, IInputFunctions<T>& Functions, std::vector<T>& B, int col, int count)
+    {
+        global_vector(in, Functions, B, col, count);
+        conditions_rhs(in, B, col, count);
+    }
+
+    //      count      prepare_FEM.
+    //    B    .
+    void solve_block(std::vector<T>& B, int count)
+    {
+        forward_block(B, count);
+        backward_block(B, count);
+    }
+
     //       
     // -div(lambda(x)*grad(u(x))) + gamma * u(x) = f(x)
     // q -  
@@ -312,17 +1028,30 @@ public:
     void solve_FEM(grid_in& in, IInputFunctions<T>& Functions, std::vector<T>& q)
     {
         //   
-        if (in.basis == 2)
-            global_matrix(in, *(new LocalMatrix2_lambda<T>(Functions)), *(new LocalVector2<T>(Functions)), q);
-        else if (in.basis == 3)
-            global_matrix(in, *(new LocalMatrix3_lambda<T>(Functions)), *(new LocalVector3<T>(Functions)), q);
-        else
-            throw new std::invalid_argument("Invalid basis in input");
+        global_matrix(in, Functions, q);
 
         //   
         conditions(in, q);
 
-        //  
-        solve_matrix(*this, q, q);
+        //  .
+        //     basis,     LDLT -
+        //       dim.
+        if (mixed_precision)
+            solve_mixed(q);
+        else
+        {
+            BandMatrix<T> band;
+            to_band(band);
+            if (domains > 1)
+                solve_dd(band, q, q, domains);
+            else
+            {
+                band.factorization();
+                band.solve(q, q);
+            }
+        }
+
+        if (condensation)
+            recover(in, q);
     }
 };
\ No newline at end of file
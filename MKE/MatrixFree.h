@@ -0,0 +1,408 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include "Grid.h"
+#include "Functions.h"
+#include "Element.h"
+
+/*
+            .
+
+       : MatrixFreeOperator::apply    
+    ,     Element<T, P>  .  
+      ,     ,     - 
+      dim.      (,  ),
+      :       ,
+          .
+
+        ,   Matrix::conditions:  
+        ,    :      
+     ,        .
+         .
+
+    :
+    preconditioner_jacobi -  ;
+    preconditioner_block -        
+    (basis - 1 ,  LDLT  ),  -  .
+      1  .
+
+          ,   -  ,
+             .
+*/
+
+enum pcg_preconditioner
+{
+    preconditioner_jacobi, preconditioner_block
+};
+
+template<typename T>
+struct PCGResult
+{
+    int iterations = 0;
+    //    |r| / |b|  
+    T residual = 0;
+    bool converged = false;
+};
+
+template<typename T, int P>
+class MatrixFreeOperator
+{
+public:
+    typedef Element<T, P> element;
+    static const int N = element::N;
+
+    MatrixFreeOperator(grid_in& in, IInputFunctions<T>& Functions, pcg_preconditioner preconditioner)
+        : preconditioner(preconditioner)
+    {
+        count = in.count_elements;
+        dim = P * count + 1;
+        h.resize(count);
+        gamma.resize(count);
+        lambda.resize((size_t)count * N);
+        b.assign(dim, 0);
+
+        int first_border = std::get<0>(in.r_cond), second_border = std::get<1>(in.r_cond);
+        left_dirichlet = first_border == 1;
+        right_dirichlet = second_border == 1;
+
+        //      ,   -   ,  apply
+        std::vector<T> local_b((size_t)count * N);
+        #pragma omp parallel for
+        for (int first = 0; first < count; first += batch)
+        {
+            std::array<T, batch * N> x, f;
+            int n = count - first < batch ? count - first : batch;
+
+            for (int e = 0; e < n; e++)
+                element_nodes(in, first + e, &x[e * N]);
+            Functions.lambda(x.data(), &lambda[(size_t)first * N], n * N);
+            Functions.f(x.data(), f.data(), n * N);
+
+            for (int e = 0; e < n; e++)
+            {
+                int k = first + e;
+                typename element::vector_type l_v;
+                h[k] = in.nodes[k + 1] - in.nodes[k];
+                gamma[k] = std::get<1>(in.materials[in.elems[k]]);
+                element::vector(&f[e * N], h[k], l_v);
+                for (int i = 0; i < N; i++)
+                    local_b[(size_t)k * N + i] = l_v[i];
+            }
+        }
+        for (int color = 0; color < 2; color++)
+        {
+            #pragma omp parallel for
+            for (int k = color; k < count; k += 2)
+                for (int i = 0; i < N; i++)
+                    b[k * P + i] += local_b[(size_t)k * N + i];
+        }
+
+        //  :   ,    
+        int index = 0;
+        if (first_border == 2)
+            b[0] += in.conditions[index++];
+        else if (first_border == 3)
+        {
+            beta_left = in.conditions[index++];
+            b[0] += in.conditions[index++];
+        }
+        if (second_border == 2)
+            b[dim - 1] += in.conditions[index++];
+        else if (second_border == 3)
+        {
+            beta_right = in.conditions[index++];
+            b[dim - 1] += beta_right * in.conditions[index++];
+        }
+
+        //  :       .
+        //       :   
+        //          .
+        typename element::matrix_type l_m;
+        if (left_dirichlet)
+        {
+            u_left = in.conditions[index++];
+            local(0, l_m);
+            for (int i = 1; i < N; i++)
+                b[i] -= l_m[i][0] * u_left;
+        }
+        if (right_dirichlet)
+        {
+            u_right = in.conditions[index++];
+            local(count - 1, l_m);
+            for (int i = 0; i < P; i++)
+                b[dim - 1 - P + i] -= l_m[i][P] * u_right;
+        }
+        if (left_dirichlet)
+            b[0] = u_left;
+        if (right_dirichlet)
+            b[dim - 1] = u_right;
+
+        build_preconditioner();
+    }
+
+    int size() const
+    {
+        return dim;
+    }
+
+    //      .
+    const std::vector<T>& rhs() const
+    {
+        return b;
+    }
+
+    // y = Ax. x  y   .
+    void apply(const std::vector<T>& x, std::vector<T>& y) const
+    {
+        y.assign(dim, 0);
+        for (int color = 0; color < 2; color++)
+        {
+            #pragma omp parallel for
+            for (int k = color; k < count; k += 2)
+            {
+                typename element::matrix_type l_m;
+                typename element::vector_type xl;
+                local(k, l_m);
+
+                for (int i = 0; i < N; i++)
+                    xl[i] = x[k * P + i];
+                //      
+                if (k == 0 && left_dirichlet)
+                    xl[0] = 0;
+                if (k == count - 1 && right_dirichlet)
+                    xl[P] = 0;
+
+                T* yl = &y[k * P];
+                for (int i = 0; i < N; i++)
+                {
+                    T sum = 0;
+                    for (int j = 0; j < N; j++)
+                        sum += l_m[i][j] * xl[j];
+                    yl[i] += sum;
+                }
+            }
+        }
+
+        y[0] += beta_left * x[0];
+        y[dim - 1] += beta_right * x[dim - 1];
+        if (left_dirichlet)
+            y[0] = x[0];
+        if (right_dirichlet)
+            y[dim - 1] = x[dim - 1];
+    }
+
+    // z = M^-1 r.
+    void precondition(const std::vector<T>& r, std::vector<T>& z) const
+    {
+        z.resize(dim);
+        #pragma omp parallel for
+        for (int i = 0; i < dim; i += P)
+            z[i] = r[i] * inverse_diagonal[i];
+
+        #pragma omp parallel for
+        for (int k = 0; k < count; k++)
+        {
+            T* zk = &z[k * P + 1];
+            const T* rk = &r[k * P + 1];
+            if (preconditioner == preconditioner_jacobi || P == 1)
+            {
+                for (int i = 0; i < P - 1; i++)
+                    zk[i] = rk[i] * inverse_diagonal[k * P + 1 + i];
+                continue;
+            }
+
+            //   : L D L^T z = r
+            const T* block = &blocks[(size_t)k * (P - 1) * (P - 1)];
+            for (int i = 0; i < P - 1; i++)
+            {
+                T sum = rk[i];
+                for (int j = 0; j < i; j++)
+                    sum -= block[i * (P - 1) + j] * zk[j];
+                zk[i] = sum;
+            }
+            for (int i = 0; i < P - 1; i++)
+                zk[i] /= block[i * (P - 1) + i];
+            for (int i = P - 2; i >= 0; i--)
+                for (int j = 0; j < i; j++)
+                    zk[j] -= block[i * (P - 1) + j] * zk[i];
+        }
+    }
+
+private:
+    static const int batch = 64;
+    pcg_preconditioner preconditioner;
+    int count = 0, dim = 0;
+    std::vector<T> h, gamma, lambda, b;
+    bool left_dirichlet = false, right_dirichlet = false;
+    T beta_left = 0, beta_right = 0, u_left = 0, u_right = 0;
+    std::vector<T> inverse_diagonal;
+    //  LDLT   : L  , D  
+    std::vector<T> blocks;
+
+    void local(int k, typename element::matrix_type& l_m) const
+    {
+        element::matrix(&lambda[(size_t)k * N], gamma[k], h[k], l_m);
+    }
+
+    void build_preconditioner()
+    {
+        std::vector<T> diagonal(dim, 0);
+        bool block = preconditioner == preconditioner_block && P > 1;
+        if (block)
+            blocks.resize((size_t)count * (P - 1) * (P - 1));
+
+        for (int color = 0; color < 2; color++)
+        {
+            #pragma omp parallel for
+            for (int k = color; k < count; k += 2)
+            {
+                typename element::matrix_type l_m;
+                local(k, l_m);
+                for (int i = 0; i < N; i++)
+                    diagonal[k * P + i] += l_m[i][i];
+
+                if (!block)
+                    continue;
+                T* a = &blocks[(size_t)k * (P - 1) * (P - 1)];
+                for (int i = 0; i < P - 1; i++)
+                    for (int j = 0; j <= i; j++)
+                        a[i * (P - 1) + j] = l_m[i + 1][j + 1];
+
+                // LDLT  
+                for (int i = 0; i < P - 1; i++)
+                {
+                    for (int j = 0; j < i; j++)
+                    {
+                        T sum = a[i * (P - 1) + j];
+                        for (int m = 0; m < j; m++)
+                            sum -= a[i * (P - 1) + m] * a[j * (P - 1) + m] * a[m * (P - 1) + m];
+                        a[i * (P - 1) + j] = sum / a[j * (P - 1) + j];
+                    }
+                    T d = a[i * (P - 1) + i];
+                    for (int m = 0; m < i; m++)
+                        d -= a[i * (P - 1) + m] * a[i * (P - 1) + m] * a[m * (P - 1) + m];
+                    a[i * (P - 1) + i] = d;
+                }
+            }
+        }
+
+        diagonal[0] += beta_left;
+        diagonal[dim - 1] += beta_right;
+        if (left_dirichlet)
+            diagonal[0] = 1;
+        if (right_dirichlet)
+            diagonal[dim - 1] = 1;
+
+        inverse_diagonal.resize(dim);
+        for (int i = 0; i < dim; i++)
+            inverse_diagonal[i] = 1 / diagonal[i];
+    }
+};
+
+//  :     ,     .
+template<typename T>
+T deterministic_dot(const std::vector<T>& x, const std::vector<T>& y)
+{
+    const int block = 4096;
+    int n = (int)x.size();
+    int blocks = (n + block - 1) / block;
+    std::vector<T> partial(blocks);
+
+    #pragma omp parallel for
+    for (int c = 0; c < blocks; c++)
+    {
+        int end = (c + 1) * block < n ? (c + 1) * block : n;
+        T sum = 0;
+        for (int i = c * block; i < end; i++)
+            sum += x[i] * y[i];
+        partial[c] = sum;
+    }
+
+    T sum = 0;
+    for (int c = 0; c < blocks; c++)
+        sum += partial[c];
+    return sum;
+}
+
+//        A.
+// q -   (   ,  )  .
+template<typename T, class Operator>
+PCGResult<T> pcg(const Operator& A, std::vector<T>& q, T tolerance, int max_iterations)
+{
+    int dim = A.size();
+    const std::vector<T>& b = A.rhs();
+    PCGResult<T> result;
+    if ((int)q.size() != dim)
+        q.assign(dim, 0);
+
+    std::vector<T> r(dim), z(dim), p(dim), Ap(dim);
+    A.apply(q, Ap);
+    #pragma omp parallel for
+    for (int i = 0; i < dim; i++)
+        r[i] = b[i] - Ap[i];
+
+    T norm_b = std::sqrt(deterministic_dot(b, b));
+    if (norm_b == 0)
+        norm_b = 1;
+
+    A.precondition(r, z);
+    p = z;
+    T rz = deterministic_dot(r, z);
+    result.residual = std::sqrt(deterministic_dot(r, r)) / norm_b;
+
+    while (result.residual > tolerance && result.iterations < max_iterations)
+    {
+        A.apply(p, Ap);
+        T alpha = rz / deterministic_dot(p, Ap);
+
+        #pragma omp parallel for
+        for (int i = 0; i < dim; i++)
+        {
+            q[i] += alpha * p[i];
+            r[i] -= alpha * Ap[i];
+        }
+        result.iterations++;
+        result.residual = std::sqrt(deterministic_dot(r, r)) / norm_b;
+        if (!(result.residual > tolerance))
+            break;
+
+        A.precondition(r, z);
+        T rz_next = deterministic_dot(r, z);
+        T beta = rz_next / rz;
+        rz = rz_next;
+
+        #pragma omp parallel for
+        for (int i = 0; i < dim; i++)
+            p[i] = z[i] + beta * p[i];
+    }
+
+    result.converged = result.residual <= tolerance;
+    return result;
+}
+
+//      PCG.
+// tolerance -    |b - Aq| / |b|,
+// max_iterations = 0 -   10 * dim .
+template<typename T>
+PCGResult<T> solve_pcg(grid_in& in, IInputFunctions<T>& Functions, std::vector<T>& q,
+    T tolerance = 1e-10, int max_iterations = 0, pcg_preconditioner preconditioner = preconditioner_block)
+{
+    if (max_iterations == 0)
+        max_iterations = 10 * (in.basis * in.count_elements + 1);
+
+    switch (in.basis)
+    {
+    case 1: return pcg(MatrixFreeOperator<T, 1>(in, Functions, preconditioner), q, tolerance, max_iterations);
+    case 2: return pcg(MatrixFreeOperator<T, 2>(in, Functions, preconditioner), q, tolerance, max_iterations);
+    case 3: return pcg(MatrixFreeOperator<T, 3>(in, Functions, preconditioner), q, tolerance, max_iterations);
+    case 4: return pcg(MatrixFreeOperator<T, 4>(in, Functions, preconditioner), q, tolerance, max_iterations);
+    case 5: return pcg(MatrixFreeOperator<T, 5>(in, Functions, preconditioner), q, tolerance, max_iterations);
+    case 6: return pcg(MatrixFreeOperator<T, 6>(in, Functions, preconditioner), q, tolerance, max_iterations);
+    case 7: return pcg(MatrixFreeOperator<T, 7>(in, Functions, preconditioner), q, tolerance, max_iterations);
+    case 8: return pcg(MatrixFreeOperator<T, 8>(in, Functions, preconditioner), q, tolerance, max_iterations);
+    default:
+        throw new std::invalid_argument("Invalid basis in input");
+    }
+}
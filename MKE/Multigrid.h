@@ -0,0 +1,511 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include "Matrix.cpp"
+#include "BandMatrix.h"
+
+/*
+      .
+
+     0 -     (Matrix::assemble_band).
+          -      :
+       -       (p-to-1).
+          :    
+      ,     ,     
+    (elems)   ,        .
+           :
+    u_i = -(a_{i,i-1} u_{i-1} + a_{i,i+1} u_{i+1}) / a_ii,    
+             .
+      -   P^T A P.    
+    (  coarsest )    LDLT.
+
+    :     - -  
+     p + 1    (p -  ,    
+    - ),        .
+         ,   -  ,
+       . cycle = 1 - V-, 2 - W-.
+
+             
+        (  6-8   ,   
+      5),      .    , 
+    preconditioner_block  MatrixFree.h:    -  , 
+      (LDLT      , 
+     ,   solve_dd),   - .    
+       ,     ,   -
+      .
+
+        .     
+    ,         
+    ,  - ,     (converged = false).
+          .
+
+          :   
+      ,     .
+*/
+
+enum multigrid_smoother
+{
+    smoother_jacobi, smoother_gauss_seidel
+};
+
+template<typename T>
+struct MultigridOptions
+{
+    multigrid_smoother smoother = smoother_gauss_seidel;
+    //    
+    T omega = T(2) / 3;
+    int pre_smoothing = 2, post_smoothing = 2;
+    // 1 - V-, 2 - W-
+    int cycle = 1;
+    //    |b - Aq| / (|A| |q| + |b|)   .
+    // ,   |b|,      ,  - .
+    T tolerance = 1e-13;
+    int max_cycles = 100;
+    //     
+    int coarsest = 64;
+};
+
+template<typename T>
+struct MultigridResult
+{
+    int cycles = 0, levels = 0;
+    T residual = 0;
+    bool converged = false;
+};
+
+template<typename T>
+class Multigrid
+{
+public:
+    Multigrid(grid_in& in, IInputFunctions<T>& Functions, const MultigridOptions<T>& options)
+        : options(options)
+    {
+        levels.emplace_back(new Level());
+        Level& fine = *levels[0];
+        Matrix<T> m;
+        m.assemble_band(in, Functions, fine.A, b);
+        fine.material = in.elems;
+        fine.block = in.basis;
+        fixed_left = std::get<0>(in.r_cond) == 1;
+        fixed_right = std::get<1>(in.r_cond) == 1;
+
+        if (in.basis > 1)
+            to_linear(in.basis);
+        while (levels.back()->A.dim > options.coarsest && coarsen())
+            ;
+
+        for (auto& level : levels)
+            level->prepare();
+        coarse = levels.back()->A;
+        coarse.factorization();
+
+        //        
+        BandMatrix<T>& A = fine.A;
+        std::vector<T> row(A.dim, 0);
+        for (int i = 0; i < A.dim; i++)
+        {
+            row[i] += std::fabs(A.di[i]);
+            for (int j = i - A.p < 0 ? 0 : i - A.p; j < i; j++)
+            {
+                row[i] += std::fabs(A.elem(i, j));
+                row[j] += std::fabs(A.elem(i, j));
+            }
+            norm_b = std::max(norm_b, std::fabs(b[i]));
+        }
+        norm_a = *std::max_element(row.begin(), row.end());
+    }
+
+    //  , q -   (   ,  )
+    //  .
+    MultigridResult<T> solve(std::vector<T>& q)
+    {
+        Level& fine = *levels[0];
+        int dim = fine.A.dim;
+        MultigridResult<T> result;
+        result.levels = (int)levels.size();
+        if ((int)q.size() != dim)
+            q.assign(dim, 0);
+
+        residual(fine, q, b, fine.r);
+        result.residual = backward_error(q, fine.r);
+        while (!(result.residual <= options.tolerance) && result.cycles < options.max_cycles)
+        {
+            cycle(0, b, q);
+            result.cycles++;
+            residual(fine, q, b, fine.r);
+            result.residual = backward_error(q, fine.r);
+        }
+        result.converged = result.residual <= options.tolerance;
+        return result;
+    }
+
+private:
+    struct Level
+    {
+        BandMatrix<T> A;
+        std::vector<T> inverse_diagonal;
+        //    (  )
+        std::vector<int> material;
+        //    ( ) :  i 
+        // w_left[i] * x[parent[i]] + w_right[i] * x[parent[i] + 1]
+        std::vector<int> parent;
+        std::vector<T> w_left, w_right;
+        // position[a] -     a-   
+        std::vector<int> position;
+        //  : ,     
+        std::vector<T> r, b, x;
+        //       (0 - )
+        //      
+        int block = 0;
+        BandMatrix<T> interior;
+
+        void prepare()
+        {
+            inverse_diagonal.resize(A.dim);
+            for (int i = 0; i < A.dim; i++)
+                inverse_diagonal[i] = 1 / A.di[i];
+            r.resize(A.dim);
+            b.resize(A.dim);
+            x.resize(A.dim);
+
+            if (block > 1)
+            {
+                interior = A;
+                for (int first = 1; first < A.dim; first += block)
+                    interior.factorization(first, first + block - 1);
+            }
+        }
+    };
+
+    MultigridOptions<T> options;
+    std::vector<std::unique_ptr<Level>> levels;
+    std::vector<T> b;
+    BandMatrix<T> coarse;
+    bool fixed_left = false, fixed_right = false;
+    T norm_a = 0, norm_b = 0;
+
+    //   (  NaN  x  r)   :
+    // std::max  NaN,     x   .
+    T backward_error(const std::vector<T>& x, const std::vector<T>& r) const
+    {
+        T norm_x = 0, norm_r = 0;
+        for (size_t i = 0; i < x.size(); i++)
+        {
+            if (!std::isfinite(x[i]) || !std::isfinite(r[i]))
+                return std::numeric_limits<T>::infinity();
+            norm_x = std::max(norm_x, std::fabs(x[i]));
+            norm_r = std::max(norm_r, std::fabs(r[i]));
+        }
+        T scale = norm_a * norm_x + norm_b;
+        return scale == 0 ? 0 : norm_r / scale;
+    }
+
+    //       .
+    void to_linear(int P)
+    {
+        Level& fine = *levels.back();
+        int count = (fine.A.dim - 1) / P;
+        int dim = fine.A.dim;
+
+        fine.parent.resize(dim);
+        fine.w_left.resize(dim);
+        fine.w_right.resize(dim);
+        for (int i = 0; i < dim; i++)
+        {
+            int k = i / P, m = i % P;
+            if (k == count)
+            {
+                k = count - 1;
+                m = P;
+            }
+            fine.parent[i] = k;
+            fine.w_left[i] = T(P - m) / P;
+            fine.w_right[i] = T(m) / P;
+        }
+        fine.position.resize(count + 1);
+        for (int a = 0; a <= count; a++)
+            fine.position[a] = a * P;
+
+        add_level(fine.material);
+    }
+
+    //    .  false,   .
+    bool coarsen()
+    {
+        Level& fine = *levels.back();
+        int dim = fine.A.dim;
+        int count = dim - 1;
+
+        //  ,   ,      
+        std::vector<bool> kept(dim, false);
+        kept[0] = kept[count] = true;
+        for (int i = 1; i < count; i++)
+            kept[i] = fine.material[i - 1] != fine.material[i] || !kept[i - 1];
+
+        fine.position.clear();
+        for (int i = 0; i < dim; i++)
+            if (kept[i])
+                fine.position.push_back(i);
+        int coarse_dim = (int)fine.position.size();
+        if (coarse_dim == dim)
+            return false;
+
+        fine.parent.resize(dim);
+        fine.w_left.assign(dim, 0);
+        fine.w_right.assign(dim, 0);
+        std::vector<int> material(coarse_dim - 1);
+        for (int a = 0, i = 0; i < dim; i++)
+        {
+            if (kept[i])
+            {
+                if (a < coarse_dim - 1)
+                {
+                    fine.parent[i] = a;
+                    fine.w_left[i] = 1;
+                    material[a] = fine.material[i];
+                }
+                else
+                {
+                    fine.parent[i] = a - 1;
+                    fine.w_right[i] = 1;
+                }
+                a++;
+            }
+            else
+            {
+                //    -  a - 1  a
+                fine.parent[i] = a - 1;
+                fine.w_left[i] = -fine.A.elem(i, i - 1) / fine.A.di[i];
+                fine.w_right[i] = -fine.A.elem(i + 1, i) / fine.A.di[i];
+            }
+        }
+
+        add_level(material);
+        return true;
+    }
+
+    //        .
+    void add_level(const std::vector<int>& material)
+    {
+        Level& fine = *levels.back();
+        int dim = fine.A.dim;
+        int coarse_dim = (int)fine.position.size();
+        int p = fine.A.p;
+
+        //      
+        if (fixed_left)
+            for (int i = 1; i < dim; i++)
+                if (fine.parent[i] == 0)
+                    fine.w_left[i] = 0;
+        if (fixed_right)
+            for (int i = 0; i < dim - 1; i++)
+                if (fine.parent[i] == coarse_dim - 2)
+                    fine.w_right[i] = 0;
+
+        std::unique_ptr<Level> next(new Level());
+        next->A.init(coarse_dim, 1);
+        next->material = material;
+
+        // P^T A P:  a_ij   (parent(i) + s, parent(j) + t),  
+        for (int i = 0; i < dim; i++)
+        {
+            int j0 = i - p < 0 ? 0 : i - p;
+            int j1 = i + p < dim ? i + p : dim - 1;
+            T wi[2] = { fine.w_left[i], fine.w_right[i] };
+
+            for (int j = j0; j <= j1; j++)
+            {
+                T a = j == i ? fine.A.di[i] : j < i ? fine.A.elem(i, j) : fine.A.elem(j, i);
+                if (a == 0)
+                    continue;
+                T wj[2] = { fine.w_left[j], fine.w_right[j] };
+
+                for (int s = 0; s < 2; s++)
+                    for (int t = 0; t < 2; t++)
+                    {
+                        int ci = fine.parent[i] + s, cj = fine.parent[j] + t;
+                        T value = wi[s] * a * wj[t];
+                        if (value == 0 || ci < cj)
+                            continue;
+                        if (ci == cj)
+                            next->A.di[ci] += value;
+                        else if (ci - cj == 1)
+                            next->A.elem(ci, cj) += value;
+                        else
+                            throw new std::logic_error("Coarse operator is wider than tridiagonal");
+                    }
+            }
+        }
+
+        levels.push_back(std::move(next));
+    }
+
+    // r = b - Ax
+    void residual(Level& level, const std::vector<T>& x, const std::vector<T>& b, std::vector<T>& r)
+    {
+        level.A.multiply(x, r);
+        #pragma omp parallel for
+        for (int i = 0; i < level.A.dim; i++)
+            r[i] = b[i] - r[i];
+    }
+
+    void smooth(Level& level, const std::vector<T>& b, std::vector<T>& x, int sweeps, bool reverse)
+    {
+        BandMatrix<T>& A = level.A;
+        int dim = A.dim, p = A.p;
+
+        for (int sweep = 0; sweep < sweeps; sweep++)
+        {
+            if (level.block > 1)
+            {
+                smooth_blocks(level, b, x, reverse);
+                continue;
+            }
+
+            if (options.smoother == smoother_jacobi)
+            {
+                residual(level, x, b, level.r);
+                #pragma omp parallel for
+                for (int i = 0; i < dim; i++)
+                    x[i] += options.omega * level.inverse_diagonal[i] * level.r[i];
+                continue;
+            }
+
+            for (int c = 0; c <= p; c++)
+            {
+                int color = reverse ? p - c : c;
+                #pragma omp parallel for
+                for (int i = color; i < dim; i += p + 1)
+                    relax(level, b, x, i);
+            }
+        }
+    }
+
+    //  -   i.
+    static void relax(Level& level, const std::vector<T>& b, std::vector<T>& x, int i)
+    {
+        BandMatrix<T>& A = level.A;
+        int dim = A.dim, p = A.p;
+        int j0 = i - p < 0 ? 0 : i - p;
+        int j1 = i + p < dim ? i + p : dim - 1;
+        const T* li = &A.al[(size_t)i * p];
+        T sum = b[i];
+
+        for (int j = j0; j < i; j++)
+            sum -= li[j - i + p] * x[j];
+        for (int j = i + 1; j <= j1; j++)
+            sum -= A.al[(size_t)j * p + i - j + p] * x[j];
+        x[i] = sum * level.inverse_diagonal[i];
+    }
+
+    //         block.
+    // -:   ,   (  - ).
+    // :      x,       omega.
+    void smooth_blocks(Level& level, const std::vector<T>& b, std::vector<T>& x, bool reverse)
+    {
+        BandMatrix<T>& A = level.A;
+        int P = level.block, count = (A.dim - 1) / P;
+
+        if (options.smoother == smoother_jacobi)
+        {
+            residual(level, x, b, level.r);
+            #pragma omp parallel for
+            for (int k = 0; k < count; k++)
+            {
+                int first = k * P + 1, last = k * P + P;
+                level.interior.forward(level.r, level.r, first, last);
+                level.interior.backward(level.r, level.r, first, last);
+                for (int i = first; i < last; i++)
+                    x[i] += options.omega * level.r[i];
+            }
+            #pragma omp parallel for
+            for (int v = 0; v <= count; v++)
+                x[v * P] += options.omega * level.inverse_diagonal[v * P] * level.r[v * P];
+            return;
+        }
+
+        for (int pass = 0; pass < 2; pass++)
+        {
+            if ((pass == 0) != reverse)
+            {
+                //        
+                #pragma omp parallel for
+                for (int k = 0; k < count; k++)
+                {
+                    int left = k * P, right = k * P + P;
+                    for (int i = left + 1; i < right; i++)
+                        level.r[i] = b[i] - A.elem(i, left) * x[left] - A.elem(right, i) * x[right];
+                    level.interior.forward(level.r, level.r, left + 1, right);
+                    level.interior.backward(x, level.r, left + 1, right);
+                }
+            }
+            else
+            {
+                for (int c = 0; c < 2; c++)
+                {
+                    int color = reverse ? 1 - c : c;
+                    #pragma omp parallel for
+                    for (int v = color; v <= count; v += 2)
+                        relax(level, b, x, v * P);
+                }
+            }
+        }
+    }
+
+    void cycle(int l, const std::vector<T>& b, std::vector<T>& x)
+    {
+        Level& level = *levels[l];
+        if (l == (int)levels.size() - 1)
+        {
+            coarse.solve(x, b);
+            return;
+        }
+
+        Level& next = *levels[l + 1];
+        smooth(level, b, x, options.pre_smoothing, false);
+        residual(level, x, b, level.r);
+
+        //  P^T r:   a      
+        int coarse_dim = next.A.dim, dim = level.A.dim;
+        #pragma omp parallel for
+        for (int a = 0; a < coarse_dim; a++)
+        {
+            int i0 = a == 0 ? 0 : level.position[a - 1];
+            int i1 = a == coarse_dim - 1 ? dim - 1 : level.position[a + 1];
+            T sum = 0;
+            for (int i = i0; i <= i1; i++)
+            {
+                if (level.parent[i] == a)
+                    sum += level.w_left[i] * level.r[i];
+                else if (level.parent[i] == a - 1)
+                    sum += level.w_right[i] * level.r[i];
+            }
+            next.b[a] = sum;
+        }
+
+        std::fill(next.x.begin(), next.x.end(), 0);
+        for (int c = 0; c < options.cycle; c++)
+            cycle(l + 1, next.b, next.x);
+
+        #pragma omp parallel for
+        for (int i = 0; i < dim; i++)
+        {
+            int a = level.parent[i];
+            x[i] += level.w_left[i] * next.x[a] + level.w_right[i] * next.x[a + 1];
+        }
+
+        smooth(level, b, x, options.post_smoothing, true);
+    }
+};
+
+//     , q - .
+template<typename T>
+MultigridResult<T> solve_multigrid(grid_in& in, IInputFunctions<T>& Functions, std::vector<T>& q,
+    const MultigridOptions<T>& options = MultigridOptions<T>())
+{
+    return Multigrid<T>(in, Functions, options).solve(q);
+}
@@ -0,0 +1,487 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include "Grid.h"
+#include "Functions.h"
+#include "Element.h"
+
+/*
+      -div(lambda(x, u) grad u) + (gamma + g(x, u)) u = f(x)
+    (. INonlinearFunctions)    ()  .
+
+          :    lambda(x, u)
+     gamma + g(x, u)   ,   - Element::matrix
+       .  R(u) = A(u) u - b.
+      A(u) d = -R(u),  - J(u) d = -R(u),  
+    J = A + dA/du u:   lambda_m    u_m, 
+    J_ij = A_ij + dlambda_j / h * sum_l GL[j][i][l] u_l + h * dg_j * sum_l MM[j][i][l] u_l.
+    J ,         al  au
+      LU    .
+
+     ia,  ,       
+     .     : 
+         ,    
+       ,   Matrix::global_matrix.
+
+     d   (line search): u + alpha d  alpha = 1, 1/2, ...
+    ,      |R|   (1 - 1e-4 alpha) .
+         max_halvings ,    :
+          ,   |R| 
+       ,          .
+             .   
+        ,       ,
+         -   ,     .
+*/
+
+enum nonlinear_method
+{
+    method_picard, method_newton
+};
+
+template<typename T>
+struct NonlinearOptions
+{
+    nonlinear_method method = method_newton;
+    // : |R| <= tolerance * |R( )|
+    //  |alpha d| <= step_tolerance * |u|,  
+    T tolerance = 1e-12;
+    T step_tolerance = 1e-12;
+    int max_iterations = 50;
+    bool line_search = true;
+    //      :  2    - 1/4
+    int max_halvings = 2;
+};
+
+// :   ,  ,  ,   
+//    (. solve)     .
+template<typename T>
+struct NonlinearIteration
+{
+    T residual, step, damping;
+    bool picard;
+    double assembly, factorization, solve;
+};
+
+template<typename T>
+struct NonlinearResult
+{
+    int iterations = 0;
+    bool converged = false;
+    T residual = 0;
+    std::vector<NonlinearIteration<T>> history;
+};
+
+template<typename T>
+class NonlinearProblem
+{
+public:
+    NonlinearProblem(grid_in& in, INonlinearFunctions<T>& Functions)
+        : in(in), Functions(Functions)
+    {
+        P = in.basis;
+        if (P < 1 || P > 8)
+            throw new std::invalid_argument("Invalid basis in input");
+        dim = P * in.count_elements + 1;
+
+        //   ,   Matrix::init
+        ia.resize(dim + 1);
+        ia[0] = 0;
+        for (int i = 0; i < dim; i++)
+            ia[i + 1] = ia[i] + (i == 0 ? 0 : (i - 1) % P + 1);
+        al.resize(ia[dim]);
+        au.resize(ia[dim]);
+        di.resize(dim);
+        r.resize(dim);
+        d.resize(dim);
+        trial.resize(dim);
+
+        //     Matrix::conditions
+        left = std::get<0>(in.r_cond);
+        right = std::get<1>(in.r_cond);
+        int index = 0;
+        if (left == 2)
+            left_flux = in.conditions[index++];
+        else if (left == 3)
+        {
+            // ,   Matrix::conditions_rhs,   -   beta * u_beta
+            left_beta = in.conditions[index++];
+            left_flux = in.conditions[index++];
+        }
+        if (right == 2)
+            right_flux = in.conditions[index++];
+        else if (right == 3)
+        {
+            right_beta = in.conditions[index++];
+            right_flux = right_beta * in.conditions[index++];
+        }
+        if (left == 1)
+            left_value = in.conditions[index++];
+        if (right == 1)
+            right_value = in.conditions[index];
+    }
+
+    int size() const
+    {
+        return dim;
+    }
+
+    //  , q -   (   ,  )
+    //  .
+    NonlinearResult<T> solve(std::vector<T>& q, const NonlinearOptions<T>& options = NonlinearOptions<T>())
+    {
+        typedef std::chrono::steady_clock clock;
+        NonlinearResult<T> result;
+        result.history.reserve(options.max_iterations);
+        bool newton = options.method == method_newton;
+
+        if ((int)q.size() != dim)
+            q.assign(dim, 0);
+        if (left == 1)
+            q[0] = left_value;
+        if (right == 1)
+            q[dim - 1] = right_value;
+
+        assemble(q, newton);
+        T residual = norm(r), initial = residual;
+        result.residual = residual;
+        result.converged = residual == 0;
+
+        while (!result.converged && result.iterations < options.max_iterations)
+        {
+            NonlinearIteration<T> iteration = {};
+            direction(iteration);
+
+            T alpha = 1, trial_residual = 0;
+            bool collapsed = false;
+            for (int halving = 0; ; halving++)
+            {
+                trial_residual = try_step(q, alpha, newton, iteration);
+                if (!options.line_search || trial_residual <= (1 - T(1e-4) * alpha) * residual)
+                    break;
+                if (halving == options.max_halvings)
+                {
+                    collapsed = true;
+                    break;
+                }
+                alpha /= 2;
+            }
+
+            //    -   
+            if (collapsed)
+            {
+                alpha = 1;
+                if (newton)
+                {
+                    clock::time_point begin = clock::now();
+                    assemble(q, false);
+                    iteration.assembly += std::chrono::duration<double>(clock::now() - begin).count();
+                    direction(iteration);
+                }
+                trial_residual = try_step(q, alpha, newton, iteration);
+                iteration.picard = true;
+            }
+
+            q.swap(trial);
+            residual = trial_residual;
+            iteration.residual = residual;
+            iteration.step = alpha * norm(d);
+            iteration.damping = alpha;
+            result.history.push_back(iteration);
+            result.iterations++;
+            result.residual = residual;
+            result.converged = residual <= options.tolerance * initial
+                || iteration.step <= options.step_tolerance * norm(q);
+        }
+        return result;
+    }
+
+private:
+    grid_in& in;
+    INonlinearFunctions<T>& Functions;
+    int P = 0, dim = 0;
+
+    //  : al -   , au -  
+    std::vector<int> ia;
+    std::vector<T> al, au, di;
+    // ,    
+    std::vector<T> r, d, trial;
+
+    int left = 0, right = 0;
+    T left_flux = 0, left_beta = 0, left_value = 0;
+    T right_flux = 0, right_beta = 0, right_value = 0;
+
+    //      ,   Matrix
+    static const int batch = 64;
+
+    //  ,    -      .
+    static T norm(const std::vector<T>& x)
+    {
+        T value = 0;
+        for (size_t i = 0; i < x.size(); i++)
+            value += x[i] * x[i];
+        return std::sqrt(value);
+    }
+
+    //  d = -M^-1 R    M   R.
+    void direction(NonlinearIteration<T>& iteration)
+    {
+        typedef std::chrono::steady_clock clock;
+        clock::time_point start = clock::now();
+        factorization();
+        clock::time_point factored = clock::now();
+
+        #pragma omp parallel for
+        for (int i = 0; i < dim; i++)
+            d[i] = -r[i];
+        forward(d);
+        backward(d);
+        clock::time_point solved = clock::now();
+        iteration.factorization += std::chrono::duration<double>(factored - start).count();
+        iteration.solve += std::chrono::duration<double>(solved - factored).count();
+    }
+
+    //        q + alpha d,   .
+    T try_step(const std::vector<T>& q, T alpha, bool tangent, NonlinearIteration<T>& iteration)
+    {
+        typedef std::chrono::steady_clock clock;
+        #pragma omp parallel for
+        for (int i = 0; i < dim; i++)
+            trial[i] = q[i] + alpha * d[i];
+        clock::time_point begin = clock::now();
+        assemble(trial, tangent);
+        iteration.assembly += std::chrono::duration<double>(clock::now() - begin).count();
+        return norm(r);
+    }
+
+    //     (  tangent)   u.
+    void assemble(const std::vector<T>& u, bool tangent)
+    {
+        switch (P)
+        {
+        case 1: assemble<1>(u, tangent); break;
+        case 2: assemble<2>(u, tangent); break;
+        case 3: assemble<3>(u, tangent); break;
+        case 4: assemble<4>(u, tangent); break;
+        case 5: assemble<5>(u, tangent); break;
+        case 6: assemble<6>(u, tangent); break;
+        case 7: assemble<7>(u, tangent); break;
+        case 8: assemble<8>(u, tangent); break;
+        }
+        conditions(u);
+    }
+
+    template<int Q>
+    void assemble(const std::vector<T>& u, bool tangent)
+    {
+        typedef Element<T, Q> element;
+        const int N = element::N;
+
+        #pragma omp parallel for
+        for (int i = 0; i < dim; i++)
+        {
+            di[i] = 0;
+            r[i] = 0;
+        }
+
+        for (int color = 0; color < 2; color++)
+        {
+            int count = (in.count_elements - color + 1) / 2;
+
+            #pragma omp parallel for
+            for (int c = 0; c < (count + batch - 1) / batch; c++)
+            {
+                std::array<T, batch * N> x, v, f, lambda, dlambda, gamma, dgamma;
+                std::array<T, batch> h;
+                int first = c * batch;
+                int n = count - first < batch ? count - first : batch;
+
+                for (int e = 0; e < n; e++)
+                {
+                    int k = color + 2 * (first + e);
+                    h[e] = in.nodes[k + 1] - in.nodes[k];
+                    element_nodes(in, k, &x[e * N]);
+                    for (int a = 0; a < N; a++)
+                        v[e * N + a] = u[k * Q + a];
+                }
+
+                Functions.f(x.data(), f.data(), n * N);
+                Functions.lambda(x.data(), v.data(), lambda.data(), dlambda.data(), n * N);
+                Functions.gamma(x.data(), v.data(), gamma.data(), dgamma.data(), n * N);
+
+                for (int e = 0; e < n; e++)
+                {
+                    int k = color + 2 * (first + e);
+                    const T* ue = &v[e * N];
+                    T* ge = &gamma[e * N];
+                    T material = std::get<1>(in.materials[in.elems[k]]);
+                    for (int a = 0; a < N; a++)
+                        ge[a] += material;
+
+                    typename element::matrix_type l_m;
+                    typename element::vector_type l_v;
+                    element::matrix(&lambda[e * N], ge, h[e], l_m);
+                    element::vector(&f[e * N], h[e], l_v);
+
+                    //     A(u),   
+                    for (int i = 0; i < N; i++)
+                    {
+                        T sum = -l_v[i];
+                        for (int j = 0; j < N; j++)
+                            sum += l_m[i][j] * ue[j];
+                        r[k * Q + i] += sum;
+                    }
+
+                    if (tangent)
+                        add_tangent<Q>(&dlambda[e * N], &dgamma[e * N], ue, h[e], l_m);
+
+                    //    al  au   ,   Matrix::insert_local
+                    int stop = k * (N * (N - 1) / 2);
+                    for (int i = 0; i < N; i++)
+                    {
+                        di[k * Q + i] += l_m[i][i];
+                        for (int j = 0; j < i; j++, stop++)
+                        {
+                            al[stop] = l_m[i][j];
+                            au[stop] = l_m[j][i];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // A_ij += dlambda_j / h * sum_l GL[j][i][l] u_l + h * dgamma_j * sum_l MM[j][i][l] u_l
+    template<int Q>
+    static void add_tangent(const T* dlambda, const T* dgamma, const T* u, T h,
+        typename Element<T, Q>::matrix_type& A)
+    {
+        typedef Element<T, Q> element;
+        const int N = element::N;
+
+        for (int j = 0; j < N; j++)
+        {
+            if (dlambda[j] == 0 && dgamma[j] == 0)
+                continue;
+            for (int i = 0; i < N; i++)
+            {
+                T g = 0, m = 0;
+                for (int l = 0; l < N; l++)
+                {
+                    g += element::reference.GL[j][i][l] * u[l];
+                    m += element::reference.MM[j][i][l] * u[l];
+                }
+                A[i][j] += dlambda[j] * g / h + dgamma[j] * m * h;
+            }
+        }
+    }
+
+    //      .    ,
+    //    -    .
+    void conditions(const std::vector<T>& u)
+    {
+        int last = dim - 1;
+
+        if (left == 1)
+        {
+            di[0] = 1;
+            r[0] = u[0] - left_value;
+            for (int i = 1; i <= P; i++)
+                au[ia[i]] = 0;
+        }
+        else
+        {
+            di[0] += left_beta;
+            r[0] += left_beta * u[0] - left_flux;
+        }
+
+        if (right == 1)
+        {
+            di[last] = 1;
+            r[last] = u[last] - right_value;
+            for (int k = ia[last]; k < ia[last + 1]; k++)
+                al[k] = 0;
+        }
+        else
+        {
+            di[last] += right_beta;
+            r[last] += right_beta * u[last] - right_flux;
+        }
+    }
+
+    //  LU  : L     al, U -  au  di.
+    void factorization()
+    {
+        for (int i = 0; i < dim; i++)
+        {
+            int i0 = ia[i];
+            int i1 = ia[i + 1];
+            int j = i - (i1 - i0);
+            T sum_di = 0;
+
+            for (int k = i0; k < i1; k++, j++)
+            {
+                int j0 = ia[j];
+                int j1 = ia[j + 1];
+
+                //     i   j
+                int ki = i0;
+                int kj = j0;
+                int kur = (k - i0) - (j1 - j0);
+                if (kur > 0)
+                    ki += kur;
+                else
+                    kj -= kur;
+
+                T sum_l = 0, sum_u = 0;
+                for (; ki < k; ki++, kj++)
+                {
+                    sum_l += al[ki] * au[kj];
+                    sum_u += al[kj] * au[ki];
+                }
+
+                al[k] = (al[k] - sum_l) / di[j];
+                au[k] -= sum_u;
+                sum_di += al[k] * au[k];
+            }
+
+            di[i] -= sum_di;
+            if (di[i] == 0)
+                throw new std::invalid_argument("Matrix is singular");
+        }
+    }
+
+    // Ly = b  
+    void forward(std::vector<T>& y)
+    {
+        for (int i = 0; i < dim; i++)
+        {
+            T elem = y[i];
+            for (int k = ia[i], j = i - (ia[i + 1] - ia[i]); k < ia[i + 1]; k++, j++)
+                elem -= al[k] * y[j];
+            y[i] = elem;
+        }
+    }
+
+    // Ux = y  ,   U
+    void backward(std::vector<T>& x)
+    {
+        for (int i = dim - 1; i >= 0; i--)
+        {
+            T xi = x[i] /= di[i];
+            for (int k = ia[i], j = i - (ia[i + 1] - ia[i]); k < ia[i + 1]; k++, j++)
+                x[j] -= au[k] * xi;
+        }
+    }
+};
+
+//   , q -   (  - )  .
+template<typename T>
+NonlinearResult<T> solve_nonlinear(grid_in& in, INonlinearFunctions<T>& Functions, std::vector<T>& q,
+    const NonlinearOptions<T>& options = NonlinearOptions<T>())
+{
+    return NonlinearProblem<T>(in, Functions).solve(q, options);
+}
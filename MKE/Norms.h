@@ -0,0 +1,168 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include "Grid.h"
+#include "Functions.h"
+#include "Element.h"
+
+/*
+      e = u - u_h     .
+
+    L2 -    e^2, H1 - ,    e'^2,
+    energy -  ,    lambda e'^2 + gamma e^2.
+          -  order ,
+            ,   
+         .
+
+          element_L2, element_H1, element_energy
+    (,    ).   
+      batch,            ,
+           .
+
+      Case,  f  lambda,     u(x)  
+     du(x),  test1  test2.
+*/
+template<typename T>
+struct ErrorNorms
+{
+    T L2 = 0, H1 = 0, energy = 0;
+    //      
+    std::vector<T> element_L2, element_H1, element_energy;
+};
+
+//      .
+const int max_norm_order = 32;
+
+template<typename T, int P, class Case>
+void error_norms(grid_in& in, const std::vector<T>& q, Case& Functions, int order, ErrorNorms<T>& norms)
+{
+    const int N = P + 1;
+    const int batch = 64;
+
+    if ((int)q.size() != P * in.count_elements + 1)
+        throw new std::invalid_argument("Solution size does not match the grid");
+    if (order < 1 || order > max_norm_order)
+        throw new std::invalid_argument("Quadrature order have to be in range [1, 32]");
+
+    //     [0, 1],       ksi  
+    double t[max_norm_order], w[max_norm_order];
+    gauss_legendre(order, t, w);
+    std::vector<T> phi(N * order), dphi(N * order);
+    for (int i = 0; i < N; i++)
+        for (int g = 0; g < order; g++)
+        {
+            phi[i * order + g] = (T)lagrange(P, i, t[g]);
+            dphi[i * order + g] = (T)lagrange_derivative(P, i, t[g]);
+        }
+
+    int count = in.count_elements;
+    int blocks = (count + batch - 1) / batch;
+    norms.element_L2.resize(count);
+    norms.element_H1.resize(count);
+    norms.element_energy.resize(count);
+    std::vector<T> block_L2(blocks), block_H1(blocks), block_energy(blocks);
+
+    #pragma omp parallel for
+    for (int b = 0; b < blocks; b++)
+    {
+        std::array<T, batch * max_norm_order> x, lambda;
+        std::array<T, max_norm_order> u, du;
+        int first = b * batch;
+        int n = count - first < batch ? count - first : batch;
+
+        for (int e = 0; e < n; e++)
+        {
+            T x0 = in.nodes[first + e], h = in.nodes[first + e + 1] - x0;
+            for (int g = 0; g < order; g++)
+                x[e * order + g] = x0 + h * (T)t[g];
+        }
+        Functions.lambda(x.data(), lambda.data(), n * order);
+
+        T sum_L2 = 0, sum_H1 = 0, sum_energy = 0;
+        for (int e = 0; e < n; e++)
+        {
+            int k = first + e;
+            T h = in.nodes[k + 1] - in.nodes[k];
+            T gamma = std::get<1>(in.materials[in.elems[k]]);
+            const T* uk = &q[k * P];
+            const T* xk = &x[e * order];
+
+            for (int g = 0; g < order; g++)
+            {
+                T xi = xk[g];
+                u[g] = Functions.u(xi);
+                du[g] = Functions.du(xi);
+            }
+
+            // e = u - u_h   
+            for (int i = 0; i < N; i++)
+            {
+                const T* phi_i = &phi[i * order];
+                const T* dphi_i = &dphi[i * order];
+                T c = uk[i], dc = uk[i] / h;
+                for (int g = 0; g < order; g++)
+                {
+                    u[g] -= c * phi_i[g];
+                    du[g] -= dc * dphi_i[g];
+                }
+            }
+
+            T L2 = 0, H1 = 0, energy = 0;
+            for (int g = 0; g < order; g++)
+            {
+                T e2 = (T)w[g] * u[g] * u[g];
+                T de2 = (T)w[g] * du[g] * du[g];
+                L2 += e2;
+                H1 += de2;
+                energy += lambda[e * order + g] * de2 + gamma * e2;
+            }
+
+            norms.element_L2[k] = L2 * h;
+            norms.element_H1[k] = H1 * h;
+            norms.element_energy[k] = energy * h;
+            sum_L2 += L2 * h;
+            sum_H1 += H1 * h;
+            sum_energy += energy * h;
+        }
+
+        block_L2[b] = sum_L2;
+        block_H1[b] = sum_H1;
+        block_energy[b] = sum_energy;
+    }
+
+    T L2 = 0, H1 = 0, energy = 0;
+    for (int b = 0; b < blocks; b++)
+    {
+        L2 += block_L2[b];
+        H1 += block_H1[b];
+        energy += block_energy[b];
+    }
+    norms.L2 = std::sqrt(L2);
+    norms.H1 = std::sqrt(H1);
+    norms.energy = std::sqrt(energy);
+}
+
+//    q. order -     ,
+// 0 - basis + 2  (     2 * basis + 3).
+template<typename T, class Case>
+void error_norms(grid_in& in, const std::vector<T>& q, Case& Functions, ErrorNorms<T>& norms, int order = 0)
+{
+    if (order == 0)
+        order = in.basis + 2;
+
+    switch (in.basis)
+    {
+    case 1: error_norms<T, 1>(in, q, Functions, order, norms); break;
+    case 2: error_norms<T, 2>(in, q, Functions, order, norms); break;
+    case 3: error_norms<T, 3>(in, q, Functions, order, norms); break;
+    case 4: error_norms<T, 4>(in, q, Functions, order, norms); break;
+    case 5: error_norms<T, 5>(in, q, Functions, order, norms); break;
+    case 6: error_norms<T, 6>(in, q, Functions, order, norms); break;
+    case 7: error_norms<T, 7>(in, q, Functions, order, norms); break;
+    case 8: error_norms<T, 8>(in, q, Functions, order, norms); break;
+    default:
+        throw new std::invalid_argument("Invalid basis in input");
+    }
+}
@@ -0,0 +1,304 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <string>
+#include <fstream>
+#include <future>
+#include <cstdio>
+#include <stdexcept>
+#include "Grid.h"
+#include "Functions.h"
+#include "Element.h"
+#include "BandMatrix.h"
+#include "Streaming.h"
+
+/*
+     ,      .
+
+       ,   solve_stream:    ,
+        LDLT      .
+      ( L,  D  y)     rows 
+        ,    .
+         :    ,
+        ,       .
+
+              basis + 1   ,
+               .
+*/
+template<typename T, int P>
+class OutOfCore
+{
+public:
+    // budget -       .
+    OutOfCore(size_t budget)
+    {
+        rows = budget / (2 * (stride + 1) * sizeof(T));
+        // ,      ,     
+        if (rows < P)
+            throw new std::invalid_argument("Panel budget is too small for this basis");
+    }
+
+    //  ,     solution: dim   T .
+    // scratch -    ,   .
+    int solve(grid_in& in, mesh_spec& mesh, IInputFunctions<T>& Functions, std::string scratch, std::string solution)
+    {
+        dim = P * mesh.count_elements + 1;
+        for (Panel& panel : panels)
+        {
+            panel.rows.assign(rows * stride, 0);
+            panel.x.assign(rows, 0);
+            panel.begin = 0;
+            panel.count = 0;
+        }
+        current = 0;
+
+        factor_file.open(scratch, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        solution_file.open(solution, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!factor_file.is_open() || !solution_file.is_open())
+            throw new std::invalid_argument("Can not open scratch or solution file");
+
+        forward(in, mesh, Functions);
+        backward();
+
+        factor_file.close();
+        solution_file.close();
+        std::remove(scratch.c_str());
+        return dim;
+    }
+
+private:
+    typedef Element<T, P> element;
+    static const int N = element::N;
+    //    : P  L,  D  y (  ).
+    static const int stride = P + 2;
+
+    struct Panel
+    {
+        std::vector<T> rows;
+        //       
+        std::vector<T> x;
+        int begin, count;
+        std::future<void> reading;
+    };
+
+    int dim = 0;
+    size_t rows = 0;
+    Panel panels[2];
+    int current = 0;
+    std::fstream factor_file;
+    std::ofstream solution_file;
+    //   .       .
+    std::future<void> writing;
+
+    //    i,        .
+    T* record(int i)
+    {
+        Panel& panel = i >= panels[current].begin ? panels[current] : panels[1 - current];
+        return &panel.rows[(size_t)(i - panel.begin) * stride];
+    }
+
+    // ,    .     factor_file.
+    void forward(grid_in& in, mesh_spec& mesh, IInputFunctions<T>& Functions)
+    {
+        //   N  k- ,  0 -     
+        BandMatrix<T> window;
+        std::vector<T> b(N, 0), w(P);
+        window.init(N, P);
+
+        StreamConditions<T> conditions(in);
+
+        mesh.for_each_element([&](int k, double x0, double x1, int material)
+        {
+            typename element::vector_type x, lambda, f, l_v;
+            typename element::matrix_type l_m;
+            T h = x1 - x0;
+
+            element_nodes<T>(x0, x1, P, x.data());
+            Functions.lambda(x.data(), lambda.data(), N);
+            Functions.f(x.data(), f.data(), N);
+            element::matrix(lambda.data(), std::get<1>(in.materials[material]), h, l_m);
+            element::vector(f.data(), h, l_v);
+
+            for (int i = 0; i < N; i++)
+            {
+                window.di[i] += l_m[i][i];
+                b[i] += l_v[i];
+                for (int j = 0; j < i; j++)
+                    window.elem(i, j) += l_m[i][j];
+            }
+
+            if (k == 0)
+                conditions.left(window, b);
+
+            int count = P;
+            if (k == mesh.count_elements - 1)
+            {
+                conditions.right(window, b);
+                count = N;
+            }
+
+            for (int r = 0; r < count; r++)
+                factor_row(k * P + r, &window.al[r * P], window.di[r], b[r], w);
+
+            //         
+            std::copy(window.al.begin() + P * P, window.al.end(), window.al.begin());
+            std::fill(window.al.begin() + P, window.al.end(), 0);
+            window.di[0] = window.di[P];
+            std::fill(window.di.begin() + 1, window.di.end(), 0);
+            b[0] = b[P];
+            std::fill(b.begin() + 1, b.end(), 0);
+        });
+    }
+
+    //   i (  L li,  d,   bi),
+    //           .
+    void factor_row(int i, const T* li, T d, T bi, std::vector<T>& w)
+    {
+        Panel& panel = panels[current];
+        T* row = &panel.rows[(size_t)panel.count * stride];
+        int j0 = i - P < 0 ? 0 : i - P;
+        T sum_di = 0;
+
+        for (int c = 0; c < P; c++)
+            row[c] = li[c];
+
+        for (int j = j0; j < i; j++)
+        {
+            const T* lj = record(j);
+            T sum = 0;
+            for (int k = j0; k < j; k++)
+                sum += w[k - i + P] * lj[k - j + P];
+
+            T a = row[j - i + P] - sum;
+            w[j - i + P] = a;
+            row[j - i + P] = a / lj[P];
+            sum_di += a * row[j - i + P];
+        }
+
+        d -= sum_di;
+        if (d == 0)
+            throw new std::invalid_argument("Matrix is singular");
+
+        for (int j = j0; j < i; j++)
+            bi -= row[j - i + P] * record(j)[P + 1];
+
+        row[P] = d;
+        row[P + 1] = bi;
+
+        if ((size_t)++panel.count == rows && i + 1 < dim)
+            next_panel();
+    }
+
+    //         .
+    //       ,    .
+    void next_panel()
+    {
+        Panel& full = panels[current];
+        if (writing.valid())
+            writing.get();
+
+        writing = std::async(std::launch::async, [this, &full]()
+        {
+            factor_file.seekp((std::streamoff)full.begin * stride * sizeof(T));
+            factor_file.write((const char*)full.rows.data(), (std::streamsize)full.count * stride * sizeof(T));
+            if (!factor_file)
+                throw new std::runtime_error("Can not write scratch file");
+        });
+
+        current = 1 - current;
+        panels[current].begin = full.begin + full.count;
+        panels[current].count = 0;
+    }
+
+    //   DL^T x = y    .
+    //      P     carry.
+    void backward()
+    {
+        std::array<T, P> carry{};
+        int last = (dim - 1) / (int)rows;
+
+        for (int k = last; k >= 0; k--)
+        {
+            Panel& panel = panels[current];
+            Panel& other = panels[1 - current];
+
+            //           
+            if (k > 0 && k != last)
+            {
+                if (writing.valid())
+                    writing.get();
+                other.begin = (k - 1) * (int)rows;
+                other.count = (int)rows;
+                other.reading = std::async(std::launch::async, [this, &other]()
+                {
+                    factor_file.seekg((std::streamoff)other.begin * stride * sizeof(T));
+                    factor_file.read((char*)other.rows.data(), (std::streamsize)other.count * stride * sizeof(T));
+                    if (!factor_file)
+                        throw new std::runtime_error("Can not read scratch file");
+                });
+            }
+
+            int begin = panel.begin, count = panel.count;
+            for (int r = 0; r < count; r++)
+                panel.x[r] = panel.rows[(size_t)r * stride + P + 1] / panel.rows[(size_t)r * stride + P];
+
+            if (k != last)
+                for (int t = 0; t < P; t++)
+                    panel.x[count - P + t] += carry[t];
+            carry.fill(0);
+
+            for (int r = count - 1; r >= 0; r--)
+            {
+                int i = begin + r;
+                const T* li = &panel.rows[(size_t)r * stride];
+                int j0 = i - P < 0 ? 0 : i - P;
+                T xi = panel.x[r];
+
+                for (int j = j0; j < i; j++)
+                    if (j >= begin)
+                        panel.x[j - begin] -= li[j - i + P] * xi;
+                    else
+                        carry[j - begin + P] -= li[j - i + P] * xi;
+            }
+
+            if (writing.valid())
+                writing.get();
+            writing = std::async(std::launch::async, [this, &panel]()
+            {
+                solution_file.seekp((std::streamoff)panel.begin * sizeof(T));
+                solution_file.write((const char*)panel.x.data(), (std::streamsize)panel.count * sizeof(T));
+                if (!solution_file)
+                    throw new std::runtime_error("Can not write solution file");
+            });
+
+            if (other.reading.valid())
+                other.reading.get();
+            current = 1 - current;
+        }
+
+        if (writing.valid())
+            writing.get();
+    }
+};
+
+//       mesh.txt   .
+//     solution (dim   T ), scratch -  .
+// budget -     .   .
+template<typename T>
+int solve_out_of_core(grid_in& in, mesh_spec& mesh, IInputFunctions<T>& Functions,
+    std::string scratch, std::string solution, size_t budget)
+{
+    switch (in.basis)
+    {
+    case 1: return OutOfCore<T, 1>(budget).solve(in, mesh, Functions, scratch, solution);
+    case 2: return OutOfCore<T, 2>(budget).solve(in, mesh, Functions, scratch, solution);
+    case 3: return OutOfCore<T, 3>(budget).solve(in, mesh, Functions, scratch, solution);
+    case 4: return OutOfCore<T, 4>(budget).solve(in, mesh, Functions, scratch, solution);
+    case 5: return OutOfCore<T, 5>(budget).solve(in, mesh, Functions, scratch, solution);
+    case 6: return OutOfCore<T, 6>(budget).solve(in, mesh, Functions, scratch, solution);
+    case 7: return OutOfCore<T, 7>(budget).solve(in, mesh, Functions, scratch, solution);
+    case 8: return OutOfCore<T, 8>(budget).solve(in, mesh, Functions, scratch, solution);
+    default:
+        throw new std::invalid_argument("Invalid basis in input");
+    }
+}
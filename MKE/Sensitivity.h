@@ -0,0 +1,273 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+#include "Matrix.cpp"
+
+/*
+       J(u)   
+     .
+
+       m  dJ/dlambda_m  dJ/dgamma_m.  
+    A = sum_e (lambda_e K_e + gamma_e h M_e),      ,
+     dJ/dp = dJ/dp () - psi^T (dA/dp) u,  psi -   
+    A psi = dJ/du      (     ).
+    A ,   psi        ,
+       prepare_FEM,      
+        : dA_e/dgamma = h M, dA_e/dlambda = K_e / lambda.
+
+     Matrix::constant_materials   - lambda_m  materials.txt,
+     d_lambda -   .     Functions.lambda,
+     d_lambda[m] -    s_m      m
+    (lambda(x) -> s_m lambda(x),    s_m = 1).
+
+       :     ,  
+        -lambda du/dx     (SolutionFunctional).
+*/
+
+template<typename T>
+class SolutionFunctional
+{
+public:
+    // constant_materials -   Matrix,     .
+    SolutionFunctional(grid_in& in, IInputFunctions<T>& Functions, bool constant_materials = false)
+        : in(in), Functions(Functions), constant_materials(constant_materials)
+    {
+        if (in.basis < 1 || in.basis > max_basis)
+            throw new std::invalid_argument("Invalid basis in input");
+        weights.assign(in.basis * in.count_elements + 1, 0);
+    }
+
+    // J += coef * u(x)
+    void point(T x, T coef = 1)
+    {
+        int P = in.basis;
+        T h;
+        int k = element(x, h);
+        T ksi = (x - in.nodes[k]) / h;
+        for (int i = 0; i <= P; i++)
+            weights[k * P + i] += coef * (T)lagrange(P, i, ksi);
+    }
+
+    // J += coef * ( u(x)  [a, b])
+    void integral(T a, T b, T coef = 1)
+    {
+        if (b < a)
+            throw new std::invalid_argument("Integration interval have to be ordered");
+        int P = in.basis;
+        int order = P + 1;
+        double t[max_basis + 1], w[max_basis + 1];
+        gauss_legendre(order, t, w);
+
+        T h;
+        int first = element(a, h), last = element(b, h);
+        for (int k = first; k <= last; k++)
+        {
+            T x0 = std::max(a, (T)in.nodes[k]), x1 = std::min(b, (T)in.nodes[k + 1]);
+            if (x1 <= x0)
+                continue;
+            h = in.nodes[k + 1] - in.nodes[k];
+            for (int g = 0; g < order; g++)
+            {
+                T ksi = (x0 + (x1 - x0) * (T)t[g] - in.nodes[k]) / h;
+                for (int i = 0; i <= P; i++)
+                    weights[k * P + i] += coef * (x1 - x0) * (T)w[g] * (T)lagrange(P, i, ksi);
+            }
+        }
+    }
+
+    // J += coef * (-lambda du/dx)(x),    -   .
+    //    ,   :    .
+    void flux(T x, T coef = 1)
+    {
+        int P = in.basis;
+        T h;
+        int k = element(x, h);
+        T ksi = (x - in.nodes[k]) / h;
+
+        T lambda = 0;
+        if (constant_materials)
+            lambda = std::get<0>(in.materials[in.elems[k]]);
+        else
+        {
+            T nodes[max_basis + 1], values[max_basis + 1];
+            element_nodes(in, k, nodes);
+            Functions.lambda(nodes, values, P + 1);
+            for (int m = 0; m <= P; m++)
+                lambda += values[m] * (T)lagrange(P, m, ksi);
+        }
+
+        Flux term;
+        term.element = k;
+        for (int i = 0; i <= P; i++)
+        {
+            term.weights[i] = -coef * lambda * (T)lagrange_derivative(P, i, ksi) / h;
+            weights[k * P + i] += term.weights[i];
+        }
+        fluxes.push_back(term);
+    }
+
+    //     q.
+    T value(const std::vector<T>& q) const
+    {
+        T sum = 0;
+        for (size_t i = 0; i < weights.size(); i++)
+            sum += weights[i] * q[i];
+        return sum;
+    }
+
+    // dJ/du
+    const std::vector<T>& gradient() const
+    {
+        return weights;
+    }
+
+    //   dJ/dlambda_m ( ):     .
+    // d_lambda[m] +=  ,     m,   q.
+    void explicit_lambda(const std::vector<T>& q, std::vector<T>& d_lambda) const
+    {
+        int P = in.basis;
+        for (const Flux& term : fluxes)
+        {
+            int material = in.elems[term.element];
+            T sum = 0;
+            for (int i = 0; i <= P; i++)
+                sum += term.weights[i] * q[term.element * P + i];
+            if (constant_materials)
+                sum /= std::get<0>(in.materials[material]);
+            d_lambda[material] += sum;
+        }
+    }
+
+private:
+    struct Flux
+    {
+        int element;
+        std::array<T, max_basis + 1> weights;
+    };
+
+    grid_in& in;
+    IInputFunctions<T>& Functions;
+    bool constant_materials;
+    std::vector<T> weights;
+    std::vector<Flux> fluxes;
+
+    // ,  x (  - ,    - ),   .
+    int element(T x, T& h) const
+    {
+        if (x < in.nodes.front() || x > in.nodes.back())
+            throw new std::invalid_argument("Point is out of the grid");
+        int k = int(std::upper_bound(in.nodes.begin(), in.nodes.end(), (double)x) - in.nodes.begin()) - 1;
+        if (k > in.count_elements - 1)
+            k = in.count_elements - 1;
+        h = in.nodes[k + 1] - in.nodes[k];
+        return k;
+    }
+};
+
+// -psi_e^T dA_e u_e      P.
+template<typename T, int P>
+void material_gradient(grid_in& in, IInputFunctions<T>& Functions, bool constant_materials,
+    const std::vector<T>& q, const std::vector<T>& psi, std::vector<T>& d_lambda, std::vector<T>& d_gamma)
+{
+    typedef Element<T, P> element;
+    const int N = element::N;
+    const int batch = 64;
+    int materials = in.count_materials;
+
+    //   ,     :      
+    int count = in.count_elements;
+    int blocks = (count + batch - 1) / batch;
+    std::vector<T> block_lambda((size_t)blocks * materials, 0), block_gamma((size_t)blocks * materials, 0);
+
+    #pragma omp parallel for
+    for (int b = 0; b < blocks; b++)
+    {
+        std::array<T, batch * N> x, lambda;
+        int first = b * batch;
+        int n = count - first < batch ? count - first : batch;
+
+        if (!constant_materials)
+        {
+            for (int e = 0; e < n; e++)
+                element_nodes(in, first + e, &x[e * N]);
+            Functions.lambda(x.data(), lambda.data(), n * N);
+        }
+
+        T* sum_lambda = &block_lambda[(size_t)b * materials];
+        T* sum_gamma = &block_gamma[(size_t)b * materials];
+        for (int e = 0; e < n; e++)
+        {
+            int k = first + e;
+            int material = in.elems[k];
+            T h = in.nodes[k + 1] - in.nodes[k];
+            const T* u = &q[k * P];
+            const T* v = &psi[k * P];
+
+            // K_e / lambda    - G / h,  K_e
+            typename element::matrix_type K;
+            if (constant_materials)
+                element::matrix(T(1), T(0), h, K);
+            else
+                element::matrix(&lambda[e * N], T(0), h, K);
+
+            T stiffness = 0, mass = 0;
+            for (int i = 0; i < N; i++)
+                for (int j = 0; j < N; j++)
+                {
+                    stiffness += v[i] * K[i][j] * u[j];
+                    mass += v[i] * element::reference.M[i][j] * u[j];
+                }
+            sum_lambda[material] -= stiffness;
+            sum_gamma[material] -= mass * h;
+        }
+    }
+
+    for (int b = 0; b < blocks; b++)
+        for (int m = 0; m < materials; m++)
+        {
+            d_lambda[m] += block_lambda[(size_t)b * materials + m];
+            d_gamma[m] += block_gamma[(size_t)b * materials + m];
+        }
+}
+
+//   J      .
+// matrix -    prepare_FEM(in, Functions), q -  .
+//  -          
+//    .
+template<typename T>
+void material_sensitivities(Matrix<T>& matrix, grid_in& in, IInputFunctions<T>& Functions,
+    const std::vector<T>& q, const SolutionFunctional<T>& J, std::vector<T>& d_lambda, std::vector<T>& d_gamma)
+{
+    int dim = in.basis * in.count_elements + 1;
+    if ((int)q.size() != dim)
+        throw new std::invalid_argument("Solution size does not match the grid");
+
+    //  :        
+    std::vector<T> psi(J.gradient());
+    if (std::get<0>(in.r_cond) == 1)
+        psi[0] = 0;
+    if (std::get<1>(in.r_cond) == 1)
+        psi[dim - 1] = 0;
+    matrix.solve_block(psi, 1);
+
+    d_lambda.assign(in.count_materials, 0);
+    d_gamma.assign(in.count_materials, 0);
+    J.explicit_lambda(q, d_lambda);
+
+    bool constant = matrix.constant_materials;
+    switch (in.basis)
+    {
+    case 1: material_gradient<T, 1>(in, Functions, constant, q, psi, d_lambda, d_gamma); break;
+    case 2: material_gradient<T, 2>(in, Functions, constant, q, psi, d_lambda, d_gamma); break;
+    case 3: material_gradient<T, 3>(in, Functions, constant, q, psi, d_lambda, d_gamma); break;
+    case 4: material_gradient<T, 4>(in, Functions, constant, q, psi, d_lambda, d_gamma); break;
+    case 5: material_gradient<T, 5>(in, Functions, constant, q, psi, d_lambda, d_gamma); break;
+    case 6: material_gradient<T, 6>(in, Functions, constant, q, psi, d_lambda, d_gamma); break;
+    case 7: material_gradient<T, 7>(in, Functions, constant, q, psi, d_lambda, d_gamma); break;
+    case 8: material_gradient<T, 8>(in, Functions, constant, q, psi, d_lambda, d_gamma); break;
+    default:
+        throw new std::invalid_argument("Invalid basis in input");
+    }
+}
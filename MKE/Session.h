@@ -0,0 +1,321 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include "Grid.h"
+#include "Functions.h"
+#include "Element.h"
+#include "BandMatrix.h"
+#include "Streaming.h"
+
+/*
+              .
+
+       A      LDLT:
+     F ( )   R (     
+     ,    ).  F    
+      R       .
+
+     (set_material, set_node)      .
+    solve  F  R    [start, end]   
+    ""   s = end + 1:  [0, s)   F,  [s, dim)
+     R,     -    basis x basis  .
+      O((end - start) * basis^2)  O(dim * basis^2),  
+          ,      .
+
+     solve F   end, R -  start,      
+    ,   -     .
+        ,   solve_stream.
+*/
+template<typename T>
+class ProblemSession
+{
+public:
+    ProblemSession(grid_in& in, IInputFunctions<T>& Functions)
+        : in(in), Functions(Functions), conditions(this->in)
+    {
+        P = in.basis;
+        if (P < 1 || P > 8)
+            throw new std::invalid_argument("Invalid basis in input");
+        dim = P * in.count_elements + 1;
+        w.resize(P);
+
+        A.init(dim, P);
+        b.assign(dim, 0);
+        assemble(0, in.count_elements - 1);
+
+        F = A;
+        F.factorization();
+        y_forward.resize(dim);
+        F.forward(y_forward, b);
+
+        R.init(dim, P);
+        b_reverse.resize(dim);
+        y_reverse.resize(dim);
+        reverse_rows(0, dim - 1);
+        R.factorization();
+        R.forward(y_reverse, b_reverse);
+
+        forward_valid = dim;
+        reverse_valid = -1;
+        twist = dim;
+    }
+
+    // conditions   in   ,       
+    ProblemSession(const ProblemSession&) = delete;
+    ProblemSession& operator=(const ProblemSession&) = delete;
+
+    //   .
+    const grid_in& grid() const
+    {
+        return in;
+    }
+
+    //    k.
+    void set_material(int k, int material)
+    {
+        if (k < 0 || k >= in.count_elements)
+            throw new std::invalid_argument("Element index out of range");
+        if (material < 0 || material >= in.count_materials)
+            throw new std::invalid_argument("Material have to be in range [0, count materials)");
+        in.elems[k] = material;
+        edit(k, k);
+    }
+
+    //    i   x.    .
+    void set_node(int i, double x)
+    {
+        if (i < 0 || i > in.count_elements)
+            throw new std::invalid_argument("Node index out of range");
+        if ((i > 0 && x <= in.nodes[i - 1]) || (i < in.count_elements && x >= in.nodes[i + 1]))
+            throw new std::invalid_argument("Nodes have to stay monotonically increasing");
+        in.nodes[i] = x;
+        edit(i > 0 ? i - 1 : 0, i < in.count_elements ? i : in.count_elements - 1);
+    }
+
+    //      , q -   .
+    void solve(std::vector<T>& q)
+    {
+        if (first_dirty <= last_dirty)
+            refactor();
+
+        q.resize(dim);
+        if (twist >= dim)
+        {
+            F.backward(q, y_forward, 0, dim);
+            return;
+        }
+        solve_twisted(q);
+    }
+
+private:
+    grid_in in;
+    IInputFunctions<T>& Functions;
+    StreamConditions<T> conditions;
+    int P = 0, dim = 0;
+
+    //        
+    BandMatrix<T> A;
+    std::vector<T> b;
+    //      ,    [0, forward_valid)
+    BandMatrix<T> F;
+    std::vector<T> y_forward;
+    //  :  r   dim - 1 - r  A.
+    //    A  (reverse_valid, dim)
+    BandMatrix<T> R;
+    std::vector<T> b_reverse, y_reverse;
+    int forward_valid = 0, reverse_valid = 0;
+    //   A   solve
+    int first_dirty = 0, last_dirty = -1;
+    //   F  R, dim -   F
+    int twist = 0;
+    std::vector<T> w;
+
+    //   [k1, k2]     .
+    //          ,
+    //         .
+    void edit(int k1, int k2)
+    {
+        if (k1 <= 1)
+            k1 = 0;
+        if (k2 >= in.count_elements - 2)
+            k2 = in.count_elements - 1;
+        assemble(k1, k2);
+        first_dirty = std::min(first_dirty, k1 * P);
+        last_dirty = std::max(last_dirty, (k2 + 1) * P);
+    }
+
+    void assemble(int k1, int k2)
+    {
+        switch (P)
+        {
+        case 1: assemble<1>(k1, k2); break;
+        case 2: assemble<2>(k1, k2); break;
+        case 3: assemble<3>(k1, k2); break;
+        case 4: assemble<4>(k1, k2); break;
+        case 5: assemble<5>(k1, k2); break;
+        case 6: assemble<6>(k1, k2); break;
+        case 7: assemble<7>(k1, k2); break;
+        case 8: assemble<8>(k1, k2); break;
+        }
+    }
+
+    //     [k1, k2]:  r1 = k1 * P .. r2 = (k2 + 1) * P.
+    //   A,      [r1, r2],     
+    //   k1 - 1 .. k2 + 1,   A  .
+    template<int Q>
+    void assemble(int k1, int k2)
+    {
+        typedef Element<T, Q> element;
+        const int N = element::N;
+        int r1 = k1 * Q, r2 = (k2 + 1) * Q;
+
+        for (int i = r1; i <= r2; i++)
+        {
+            A.di[i] = 0;
+            b[i] = 0;
+            for (int j = std::max(r1, i - Q); j < i; j++)
+                A.elem(i, j) = 0;
+        }
+
+        int first = std::max(k1 - 1, 0), last = std::min(k2 + 1, in.count_elements - 1);
+        for (int k = first; k <= last; k++)
+        {
+            typename element::vector_type x, lambda, f, l_v;
+            typename element::matrix_type l_m;
+            T h = in.nodes[k + 1] - in.nodes[k];
+
+            element_nodes(in, k, x.data());
+            Functions.lambda(x.data(), lambda.data(), N);
+            Functions.f(x.data(), f.data(), N);
+            element::matrix(lambda.data(), std::get<1>(in.materials[in.elems[k]]), h, l_m);
+            element::vector(f.data(), h, l_v);
+
+            for (int a = 0; a < N; a++)
+            {
+                int i = k * Q + a;
+                if (i < r1 || i > r2)
+                    continue;
+                A.di[i] += l_m[a][a];
+                b[i] += l_v[a];
+                for (int c = 0; c < a; c++)
+                    if (k * Q + c >= r1)
+                        A.elem(i, k * Q + c) += l_m[a][c];
+            }
+        }
+
+        if (r1 == 0)
+            conditions.left(A, b);
+        if (r2 == dim - 1)
+            conditions.right(A, b);
+    }
+
+    //   R  b_reverse  A [begin, end]   .
+    void reverse_rows(int begin, int end)
+    {
+        for (int i = begin; i <= end; i++)
+        {
+            int r = dim - 1 - i;
+            R.di[r] = A.di[i];
+            b_reverse[r] = b[i];
+            for (int j = i + 1; j <= i + P && j < dim; j++)
+                R.elem(r, dim - 1 - j) = A.elem(j, i);
+        }
+    }
+
+    //  F  R   .
+    void refactor()
+    {
+        int start = std::min(first_dirty, forward_valid);
+        int end = std::max(last_dirty, reverse_valid);
+
+        for (int i = start; i <= end; i++)
+        {
+            F.di[i] = A.di[i];
+            std::copy(&A.al[(size_t)i * P], &A.al[(size_t)i * P] + P, &F.al[(size_t)i * P]);
+        }
+        F.factorization_rows(start, end + 1, w);
+        F.forward_rows(y_forward, b, start, end + 1);
+
+        reverse_rows(start, end);
+        R.factorization_rows(dim - 1 - end, dim - start, w);
+        R.forward_rows(y_reverse, b_reverse, dim - 1 - end, dim - start);
+
+        forward_valid = end + 1;
+        reverse_valid = start - 1;
+        first_dirty = dim;
+        last_dirty = -1;
+        twist = end + 1;
+    }
+
+    //      s = twist: X = [0, s)  F, Y = [s, dim)  R.
+    //  C = A(Y, X)     [s, s + P)  [s - P, s), 
+    //   C A_XX^-1 C^T    P  Y,   
+    // P  R,      .
+    void solve_twisted(std::vector<T>& q)
+    {
+        int s = twist;
+        int t0 = std::max(s - P, 0), nt = s - t0;
+        int na = std::min(P, dim - s);
+
+        // z[a] = L^-1 C^T e_a   [t0, s),   
+        std::vector<T> z((size_t)na * nt, 0), K((size_t)na * na, 0), g(na, 0);
+        for (int a = 0; a < na; a++)
+        {
+            T* za = &z[(size_t)a * nt];
+            for (int i = t0; i < s; i++)
+            {
+                T value = s + a - i <= P ? A.elem(s + a, i) : 0;
+                for (int j = std::max(t0, i - P); j < i; j++)
+                    value -= F.elem(i, j) * za[j - t0];
+                za[i - t0] = value;
+            }
+        }
+        for (int a = 0; a < na; a++)
+        {
+            const T* za = &z[(size_t)a * nt];
+            for (int i = 0; i < nt; i++)
+                g[a] += za[i] * y_forward[t0 + i] / F.di[t0 + i];
+            for (int c = 0; c < na; c++)
+            {
+                const T* zc = &z[(size_t)c * nt];
+                for (int i = 0; i < nt; i++)
+                    K[a * na + c] += za[i] * zc[i] / F.di[t0 + i];
+            }
+        }
+
+        //  na  R:  r = dim - 1 - (s + a)
+        int r0 = dim - s - na;
+        std::vector<T> saved_di(R.di.begin() + r0, R.di.begin() + dim - s);
+        std::vector<T> saved_al(R.al.begin() + (size_t)r0 * P, R.al.begin() + (size_t)(dim - s) * P);
+        std::vector<T> saved_b(b_reverse.begin() + r0, b_reverse.begin() + dim - s);
+
+        for (int a = 0; a < na; a++)
+        {
+            int i = s + a, r = dim - 1 - i;
+            R.di[r] = A.di[i] - K[a * na + a];
+            b_reverse[r] = b[i] - g[a];
+            for (int j = i + 1; j <= i + P && j < dim; j++)
+                R.elem(r, dim - 1 - j) = A.elem(j, i) - (j - s < na ? K[(j - s) * na + a] : 0);
+        }
+
+        std::vector<T> x(y_reverse.begin(), y_reverse.begin() + dim - s);
+        R.factorization_rows(r0, dim - s, w);
+        R.forward_rows(x, b_reverse, r0, dim - s);
+        R.backward(x, x, 0, dim - s);
+
+        std::copy(saved_di.begin(), saved_di.end(), R.di.begin() + r0);
+        std::copy(saved_al.begin(), saved_al.end(), R.al.begin() + (size_t)r0 * P);
+        std::copy(saved_b.begin(), saved_b.end(), b_reverse.begin() + r0);
+
+        for (int i = s; i < dim; i++)
+            q[i] = x[dim - 1 - i];
+
+        // X: L D L^T x_X = b_X - C^T x_Y,       [t0, s)
+        std::copy(y_forward.begin(), y_forward.begin() + s, q.begin());
+        for (int a = 0; a < na; a++)
+            for (int i = 0; i < nt; i++)
+                q[t0 + i] -= z[(size_t)a * nt + i] * q[s + a];
+        F.backward(q, q, 0, s);
+    }
+};
@@ -0,0 +1,228 @@
+#pragma once
+#include <vector>
+#include <stdexcept>
+#include "Grid.h"
+#include "Element.h"
+
+/*
+         .
+
+           q ( solve_FEM).   
+            ksi = (x - x_k) / h_k
+       .    :   
+     count_elements  ,     ,   ,
+           O(1),     -  
+       .     (, )
+         ,     .
+
+             .
+*/
+template<typename T>
+class SolutionEvaluator
+{
+public:
+    SolutionEvaluator(grid_in& in, const std::vector<T>& q)
+    {
+        switch (in.basis)
+        {
+        case 1: build<1>(in, q); break;
+        case 2: build<2>(in, q); break;
+        case 3: build<3>(in, q); break;
+        case 4: build<4>(in, q); break;
+        case 5: build<5>(in, q); break;
+        case 6: build<6>(in, q); break;
+        case 7: build<7>(in, q); break;
+        case 8: build<8>(in, q); break;
+        default:
+            throw new std::invalid_argument("Invalid basis in input");
+        }
+    }
+
+    //  ,   x.
+    int locate(T x) const
+    {
+        T position = (x - nodes[0]) * bucket_scale;
+        if (!(position > 0))
+            return 0;
+        if (position >= count)
+            return count - 1;
+
+        int b = (int)position;
+        int lo = bucket[b], hi = bucket[b + 1];
+        //        x
+        while (lo < hi)
+        {
+            int mid = (lo + hi + 1) / 2;
+            if (nodes[mid] <= x)
+                lo = mid;
+            else
+                hi = mid - 1;
+        }
+        //           x
+        while (lo > 0 && nodes[lo] > x)
+            lo--;
+        return lo;
+    }
+
+    //    x.
+    T operator()(T x) const
+    {
+        int k = locate(x);
+        return horner(k, (x - nodes[k]) * inverse_h[k]);
+    }
+
+    //   du/dx   x.       .
+    T derivative(T x) const
+    {
+        int k = locate(x);
+        T ksi = (x - nodes[k]) * inverse_h[k];
+        const T* c = &coefficients[(size_t)k * (degree + 1)];
+        T value = degree * c[degree];
+        for (int m = degree - 1; m >= 1; m--)
+            value = value * ksi + m * c[m];
+        return value * inverse_h[k];
+    }
+
+    //   count  x,   u.
+    void evaluate(const T* x, T* u, int count) const
+    {
+        dispatch<false>(x, u, count);
+    }
+
+    void evaluate(const std::vector<T>& x, std::vector<T>& u) const
+    {
+        u.resize(x.size());
+        evaluate(x.data(), u.data(), (int)x.size());
+    }
+
+    //    count  x,   du.
+    void evaluate_derivative(const T* x, T* du, int count) const
+    {
+        dispatch<true>(x, du, count);
+    }
+
+    void evaluate_derivative(const std::vector<T>& x, std::vector<T>& du) const
+    {
+        du.resize(x.size());
+        evaluate_derivative(x.data(), du.data(), (int)x.size());
+    }
+
+private:
+    //     
+    int count = 0, degree = 0;
+    std::vector<T> nodes, inverse_h;
+    //  :  k  degree + 1    k * (degree + 1),
+    //     .
+    std::vector<T> coefficients;
+    // bucket[b] - ,     b, bucket[count] = count - 1
+    std::vector<int> bucket;
+    T bucket_scale = 0;
+
+    template<int P>
+    void build(grid_in& in, const std::vector<T>& q)
+    {
+        const ReferenceElement<P>& reference = Element<T, P>::reference;
+        const int N = P + 1;
+
+        count = in.count_elements;
+        degree = P;
+        if ((int)q.size() != P * count + 1)
+            throw new std::invalid_argument("Solution size does not match the grid");
+
+        nodes.assign(in.nodes.begin(), in.nodes.end());
+        inverse_h.resize(count);
+        coefficients.assign((size_t)count * N, 0);
+
+        #pragma omp parallel for
+        for (int k = 0; k < count; k++)
+        {
+            inverse_h[k] = 1 / (nodes[k + 1] - nodes[k]);
+            T* c = &coefficients[(size_t)k * N];
+            for (int i = 0; i < N; i++)
+                for (int m = 0; m < N; m++)
+                    c[m] += q[k * P + i] * reference.monomial[i][m];
+        }
+
+        bucket.resize(count + 1);
+        bucket_scale = count / (nodes[count] - nodes[0]);
+        T width = 1 / bucket_scale;
+        for (int b = 0, k = 0; b < count; b++)
+        {
+            T left = nodes[0] + b * width;
+            while (k < count - 1 && nodes[k + 1] <= left)
+                k++;
+            bucket[b] = k;
+        }
+        bucket[count] = count - 1;
+    }
+
+    T horner(int k, T ksi) const
+    {
+        const T* c = &coefficients[(size_t)k * (degree + 1)];
+        T value = c[degree];
+        for (int m = degree - 1; m >= 0; m--)
+            value = value * ksi + c[m];
+        return value;
+    }
+
+    template<bool Derivative>
+    void dispatch(const T* x, T* u, int count) const
+    {
+        switch (degree)
+        {
+        case 1: evaluate<1, Derivative>(x, u, count); break;
+        case 2: evaluate<2, Derivative>(x, u, count); break;
+        case 3: evaluate<3, Derivative>(x, u, count); break;
+        case 4: evaluate<4, Derivative>(x, u, count); break;
+        case 5: evaluate<5, Derivative>(x, u, count); break;
+        case 6: evaluate<6, Derivative>(x, u, count); break;
+        case 7: evaluate<7, Derivative>(x, u, count); break;
+        case 8: evaluate<8, Derivative>(x, u, count); break;
+        }
+    }
+
+    //        chunk .
+    template<int P, bool Derivative>
+    void evaluate(const T* x, T* u, int count) const
+    {
+        const int N = P + 1;
+        const int chunk = 4096;
+
+        #pragma omp parallel for
+        for (int begin = 0; begin < count; begin += chunk)
+        {
+            int end = begin + chunk < count ? begin + chunk : count;
+            int k = locate(x[begin]);
+
+            for (int i = begin; i < end; i++)
+            {
+                T xi = x[i];
+                //  :       
+                if (xi < nodes[k] || xi >= nodes[k + 1])
+                {
+                    if (k + 1 < this->count && xi >= nodes[k + 1] && xi < nodes[k + 2])
+                        k++;
+                    else
+                        k = locate(xi);
+                }
+
+                const T* c = &coefficients[(size_t)k * N];
+                T ksi = (xi - nodes[k]) * inverse_h[k];
+                if (Derivative)
+                {
+                    T value = P * c[P];
+                    for (int m = P - 1; m >= 1; m--)
+                        value = value * ksi + m * c[m];
+                    u[i] = value * inverse_h[k];
+                }
+                else
+                {
+                    T value = c[P];
+                    for (int m = P - 1; m >= 0; m--)
+                        value = value * ksi + c[m];
+                    u[i] = value;
+                }
+            }
+        }
+    }
+};
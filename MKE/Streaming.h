@@ -0,0 +1,168 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <stdexcept>
+#include "Grid.h"
+#include "Functions.h"
+#include "Element.h"
+#include "BandMatrix.h"
+
+/*
+         ,   (mesh_spec).
+
+     LDLT       ,  
+    k * basis .. k * basis + basis - 1   k-    :
+         (k + 1) * basis.   
+     ,          
+      .       ,
+        ,       .
+         (dim * basis ),    .
+
+    in - ,  input_mesh: , ,  .
+*/
+
+//    .
+//    ,   Matrix::conditions:  ,  .
+template<typename T>
+class StreamConditions
+{
+public:
+    StreamConditions(grid_in& in)
+        : first_border(std::get<0>(in.r_cond)), second_border(std::get<1>(in.r_cond)), conditions(in.conditions)
+    {
+        int index = 0;
+        left_natural = index;
+        index += first_border == 2 ? 1 : first_border == 3 ? 2 : 0;
+        right_natural = index;
+        index += second_border == 2 ? 1 : second_border == 3 ? 2 : 0;
+        left_dirichlet = index;
+        index += first_border == 1 ? 1 : 0;
+        right_dirichlet = index;
+    }
+
+    //     ,  0..p  ,   .
+    void left(BandMatrix<T>& A, std::vector<T>& b)
+    {
+        if (first_border == 2)
+            b[0] += conditions[left_natural];
+        else if (first_border == 3)
+        {
+            A.di[0] += conditions[left_natural];        // beta
+            b[0] += conditions[left_natural + 1];       // ubeta
+        }
+        else
+        {
+            A.di[0] = 1;
+            b[0] = conditions[left_dirichlet];
+            for (int i = 1; i <= A.p; i++)
+            {
+                b[i] += -A.elem(i, 0) * b[0];
+                A.elem(i, 0) = 0;
+            }
+        }
+    }
+
+    //     ,  p + 1  ,   .
+    void right(BandMatrix<T>& A, std::vector<T>& b)
+    {
+        int last = A.dim - 1;
+
+        if (second_border == 2)
+            b[last] += conditions[right_natural];
+        else if (second_border == 3)
+        {
+            T beta = conditions[right_natural];
+            A.di[last] += beta;
+            b[last] += beta * conditions[right_natural + 1];
+        }
+        else
+        {
+            A.di[last] = 1;
+            b[last] = conditions[right_dirichlet];
+            for (int j = last - A.p; j < last; j++)
+            {
+                b[j] += -A.elem(last, j) * b[last];
+                A.elem(last, j) = 0;
+            }
+        }
+    }
+
+private:
+    int first_border, second_border;
+    int left_natural, right_natural, left_dirichlet, right_dirichlet;
+    std::vector<double>& conditions;
+};
+
+//  ,        P.
+template<typename T, int P>
+void solve_stream(grid_in& in, mesh_spec& mesh, IInputFunctions<T>& Functions, std::vector<T>& q)
+{
+    typedef Element<T, P> element;
+    const int N = element::N;
+
+    int dim = P * mesh.count_elements + 1;
+    BandMatrix<T> A;
+    A.init(dim, P);
+    q.assign(dim, 0);
+
+    StreamConditions<T> conditions(in);
+    std::vector<T> w(P);
+
+    mesh.for_each_element([&](int k, double x0, double x1, int material)
+    {
+        typename element::vector_type x, lambda, f, l_v;
+        typename element::matrix_type l_m;
+        int row = k * P;
+        T h = x1 - x0;
+
+        element_nodes<T>(x0, x1, P, x.data());
+        Functions.lambda(x.data(), lambda.data(), N);
+        Functions.f(x.data(), f.data(), N);
+        element::matrix(lambda.data(), std::get<1>(in.materials[material]), h, l_m);
+        element::vector(f.data(), h, l_v);
+
+        for (int i = 0; i < N; i++)
+        {
+            A.di[row + i] += l_m[i][i];
+            q[row + i] += l_v[i];
+            for (int j = 0; j < i; j++)
+                A.elem(row + i, row + j) += l_m[i][j];
+        }
+
+        if (k == 0)
+            conditions.left(A, q);
+
+        //       
+        int end = row + P;
+        if (k == mesh.count_elements - 1)
+        {
+            conditions.right(A, q);
+            end = dim;
+        }
+
+        A.factorization_rows(row, end, w);
+        A.forward_rows(q, q, row, end);
+    });
+
+    A.backward(q, q);
+}
+
+//       mesh.txt     .
+// q -  ,   Matrix::solve_FEM.
+template<typename T>
+void solve_stream(grid_in& in, mesh_spec& mesh, IInputFunctions<T>& Functions, std::vector<T>& q)
+{
+    switch (in.basis)
+    {
+    case 1: solve_stream<T, 1>(in, mesh, Functions, q); break;
+    case 2: solve_stream<T, 2>(in, mesh, Functions, q); break;
+    case 3: solve_stream<T, 3>(in, mesh, Functions, q); break;
+    case 4: solve_stream<T, 4>(in, mesh, Functions, q); break;
+    case 5: solve_stream<T, 5>(in, mesh, Functions, q); break;
+    case 6: solve_stream<T, 6>(in, mesh, Functions, q); break;
+    case 7: solve_stream<T, 7>(in, mesh, Functions, q); break;
+    case 8: solve_stream<T, 8>(in, mesh, Functions, q); break;
+    default:
+        throw new std::invalid_argument("Invalid basis in input");
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include <memory>
+#include "Matrix.cpp"
+#include "ThreadPool.h"
+
+/*
+          .
+     i    base  vary(i, in):   
+    ,   ,    .
+         ,    
+    ,     ,      .
+         : record(i, in, q, row) 
+     row  columns    i.
+*/
+template<typename T>
+void sweep(grid_in& base, int count, const std::function<void(int, grid_in&)>& vary,
+    IInputFunctions<T>& Functions, int columns,
+    const std::function<void(int, grid_in&, std::vector<T>&, T*)>& record,
+    std::vector<T>& table, ThreadPool& pool)
+{
+    table.assign((size_t)count * columns, 0);
+
+    //   
+    int threads = pool.size();
+    std::vector<std::unique_ptr<Matrix<T>>> matrices(threads);
+    std::vector<grid_in> grids(threads);
+    std::vector<std::vector<T>> solutions(threads);
+    for (int t = 0; t < threads; t++)
+        matrices[t].reset(new Matrix<T>());
+
+    pool.run(count, [&](int i, int t)
+    {
+        grid_in& in = grids[t];
+        in = base;
+        vary(i, in);
+
+        matrices[t]->solve_FEM(in, Functions, solutions[t]);
+        record(i, in, solutions[t], &table[(size_t)i * columns]);
+    });
+}
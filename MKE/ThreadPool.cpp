@@ -0,0 +1,123 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int threads)
+{
+	if (threads <= 0)
+		threads = std::thread::hardware_concurrency();
+	if (threads <= 0)
+		threads = 1;
+
+	for (int i = 0; i < threads; i++)
+		queues.emplace_back(new Queue);
+	for (int i = 0; i < threads; i++)
+		workers.emplace_back(&ThreadPool::work, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stop = true;
+	}
+	wake.notify_all();
+
+	for (auto& worker : workers)
+		worker.join();
+}
+
+int ThreadPool::size() const
+{
+	return workers.size();
+}
+
+void ThreadPool::run(int count, const std::function<void(int, int)>& job)
+{
+	if (count <= 0)
+		return;
+
+	int threads = size();
+	std::unique_lock<std::mutex> guard(lock);
+	this->job = &job;
+	error = nullptr;
+	remaining = count;
+
+	//    ,       
+	for (int t = 0; t < threads; t++)
+	{
+		std::lock_guard<std::mutex> queue_guard(queues[t]->lock);
+		int begin = (long long)count * t / threads;
+		int end = (long long)count * (t + 1) / threads;
+		for (int i = begin; i < end; i++)
+			queues[t]->tasks.push_back(i);
+	}
+
+	generation++;
+	wake.notify_all();
+	done.wait(guard, [this] { return remaining == 0; });
+
+	this->job = nullptr;
+	if (error)
+		std::rethrow_exception(error);
+}
+
+//  :     ,    .
+bool ThreadPool::pop(int self, int& task)
+{
+	int threads = queues.size();
+	for (int i = 0; i < threads; i++)
+	{
+		Queue& queue = *queues[(self + i) % threads];
+		std::lock_guard<std::mutex> guard(queue.lock);
+		if (queue.tasks.empty())
+			continue;
+
+		if (i == 0)
+		{
+			task = queue.tasks.back();
+			queue.tasks.pop_back();
+		}
+		else
+		{
+			task = queue.tasks.front();
+			queue.tasks.pop_front();
+		}
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::work(int self)
+{
+	int seen = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			wake.wait(guard, [&] { return stop || generation != seen; });
+			if (stop)
+				return;
+			seen = generation;
+		}
+
+		//       ,  job   pop:
+		//   ,     .
+		int task;
+		while (pop(self, task))
+		{
+			try
+			{
+				(*job)(task, self);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				if (!error)
+					error = std::current_exception();
+			}
+
+			std::lock_guard<std::mutex> guard(lock);
+			if (--remaining == 0)
+				done.notify_all();
+		}
+	}
+}
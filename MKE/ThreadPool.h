@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <memory>
+
+/*
+        .
+      run    ,    
+       ,     -    .
+         (   )     .
+*/
+class ThreadPool
+{
+public:
+    // threads = 0 -   .
+    ThreadPool(int threads = 0);
+    ~ThreadPool();
+
+    //  .
+    int size() const;
+
+    //   0..count-1    .
+    // job(task, thread)         (0..size()-1),
+    //        .
+    //      .
+    void run(int count, const std::function<void(int, int)>& job);
+
+private:
+    struct Queue
+    {
+        std::mutex lock;
+        std::deque<int> tasks;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Queue>> queues;
+
+    std::mutex lock;
+    std::condition_variable wake, done;
+    const std::function<void(int, int)>* job = nullptr;
+    std::exception_ptr error;
+    //  ,        .
+    int generation = 0;
+    int remaining = 0;
+    bool stop = false;
+
+    bool pop(int self, int& task);
+    void work(int self);
+};
@@ -0,0 +1,324 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include "Grid.h"
+#include "Functions.h"
+#include "Element.h"
+#include "BandMatrix.h"
+#include "Streaming.h"
+
+/*
+      sigma du/dt - div(lambda grad u) + gamma u = f.
+
+      M (sigma * h * M  , sigma   )
+      K (      ) 
+       F   .    
+    M du/dt + K u = F     - 
+        S u^{n+1} = B w + c * dt * F,    S = M + c * dt * K,
+         c = 1, B = M, w = u^n,
+     - c = 1/2, B = M - dt/2 K, w = u^n,
+     BDF2 c = 2/3, B = M, w = 4/3 u^n - 1/3 u^{n-1}.
+    S  LDLT      dt,     - 
+      B,    .   BDF2    
+      ()  M + dt K.
+
+         S  ,   solve_stream: 
+      ,       .
+                fixed.
+    f       .
+*/
+
+enum time_scheme
+{
+    scheme_backward_euler, scheme_crank_nicolson, scheme_bdf2
+};
+
+template<typename T>
+class TransientProblem
+{
+public:
+    // sigma -   du/dt   ,   -  .
+    TransientProblem(grid_in& in, IInputFunctions<T>& Functions, time_scheme scheme,
+        const std::vector<T>& sigma = std::vector<T>())
+        : scheme(scheme), conditions(boundary_of(in, boundary))
+    {
+        P = in.basis;
+        if (P < 1 || P > 8)
+            throw new std::invalid_argument("Invalid basis in input");
+        if (!sigma.empty() && (int)sigma.size() != in.count_materials)
+            throw new std::invalid_argument("Sigma have to be set for every material");
+        dim = P * in.count_elements + 1;
+        fixed_left = std::get<0>(in.r_cond) == 1;
+        fixed_right = std::get<1>(in.r_cond) == 1;
+
+        M.init(dim, P);
+        K.init(dim, P);
+        F.assign(dim, 0);
+        switch (P)
+        {
+        case 1: assemble<1>(in, Functions, sigma); break;
+        case 2: assemble<2>(in, Functions, sigma); break;
+        case 3: assemble<3>(in, Functions, sigma); break;
+        case 4: assemble<4>(in, Functions, sigma); break;
+        case 5: assemble<5>(in, Functions, sigma); break;
+        case 6: assemble<6>(in, Functions, sigma); break;
+        case 7: assemble<7>(in, Functions, sigma); break;
+        case 8: assemble<8>(in, Functions, sigma); break;
+        }
+
+        //     K  F,  -   S
+        if (!fixed_left)
+            conditions.left(K, F);
+        if (!fixed_right)
+            conditions.right(K, F);
+    }
+
+    // conditions   boundary   ,       
+    TransientProblem(const TransientProblem&) = delete;
+    TransientProblem& operator=(const TransientProblem&) = delete;
+
+    int size() const
+    {
+        return dim;
+    }
+
+    //   .  S ,    .
+    void set_step(T dt)
+    {
+        if (dt <= 0)
+            throw new std::invalid_argument("Time step have to be positive");
+        if (dt == this->dt)
+            return;
+        this->dt = dt;
+
+        T c = scheme == scheme_crank_nicolson ? T(0.5) : scheme == scheme_bdf2 ? T(2) / 3 : T(1);
+        system(c, S, fixed);
+        S.factorization();
+
+        B = M;
+        if (scheme == scheme_crank_nicolson)
+            combine(B, K, -dt / 2);
+        history.clear();
+    }
+
+    //  steps    q, q -   ,   -  .
+    //  BDF2    ,  set_step  restart
+    //        .
+    void advance(std::vector<T>& q, int steps = 1)
+    {
+        if (dt == 0)
+            throw new std::invalid_argument("Time step is not set");
+        if ((int)q.size() != dim)
+            throw new std::invalid_argument("Solution size does not match the problem");
+
+        for (int s = 0; s < steps; s++)
+        {
+            if (scheme == scheme_bdf2 && history.empty())
+            {
+                first_bdf2_step(q);
+                continue;
+            }
+
+            if (scheme == scheme_bdf2)
+            {
+                #pragma omp parallel for
+                for (int i = 0; i < dim; i++)
+                    work[i] = (4 * q[i] - history[i]) / 3;
+                history = q;
+                B.multiply(work, r);
+            }
+            else
+                B.multiply(q, r);
+
+            right_part(r, scheme == scheme_bdf2 ? T(2) / 3 * dt : dt, fixed);
+            S.solve(q, r);
+        }
+    }
+
+    //    ( BDF2),     .
+    void restart()
+    {
+        history.clear();
+    }
+
+private:
+    time_scheme scheme;
+    //    ( ),    conditions
+    grid_in boundary;
+    StreamConditions<T> conditions;
+    int P = 0, dim = 0;
+    bool fixed_left = false, fixed_right = false;
+    T dt = 0;
+
+    BandMatrix<T> M, K, S, B;
+    std::vector<T> F;
+    //        S
+    std::vector<T> fixed;
+    //    BDF2   
+    std::vector<T> history, work, r;
+
+    static grid_in& boundary_of(const grid_in& in, grid_in& boundary)
+    {
+        boundary.r_cond = in.r_cond;
+        boundary.conditions = in.conditions;
+        return boundary;
+    }
+
+    template<int Q>
+    void assemble(grid_in& in, IInputFunctions<T>& Functions, const std::vector<T>& sigma)
+    {
+        typedef Element<T, Q> element;
+        const int N = element::N;
+
+        for (int k = 0; k < in.count_elements; k++)
+        {
+            typename element::vector_type x, lambda, f, l_v;
+            typename element::matrix_type l_m;
+            T h = in.nodes[k + 1] - in.nodes[k];
+            T s = sigma.empty() ? T(1) : sigma[in.elems[k]];
+
+            element_nodes(in, k, x.data());
+            Functions.lambda(x.data(), lambda.data(), N);
+            Functions.f(x.data(), f.data(), N);
+            element::matrix(lambda.data(), std::get<1>(in.materials[in.elems[k]]), h, l_m);
+            element::vector(f.data(), h, l_v);
+
+            for (int a = 0; a < N; a++)
+            {
+                int i = k * Q + a;
+                K.di[i] += l_m[a][a];
+                M.di[i] += s * h * element::reference.M[a][a];
+                F[i] += l_v[a];
+                for (int c = 0; c < a; c++)
+                {
+                    K.elem(i, k * Q + c) += l_m[a][c];
+                    M.elem(i, k * Q + c) += s * h * element::reference.M[a][c];
+                }
+            }
+        }
+    }
+
+    // A += coef * X     .
+    static void combine(BandMatrix<T>& A, const BandMatrix<T>& X, T coef)
+    {
+        for (size_t i = 0; i < A.di.size(); i++)
+            A.di[i] += coef * X.di[i];
+        for (size_t i = 0; i < A.al.size(); i++)
+            A.al[i] += coef * X.al[i];
+    }
+
+    // A = M + c * dt * K    , bc -     .
+    void system(T c, BandMatrix<T>& A, std::vector<T>& bc)
+    {
+        A = M;
+        combine(A, K, c * dt);
+        bc.assign(dim, 0);
+        if (fixed_left)
+            conditions.left(A, bc);
+        if (fixed_right)
+            conditions.right(A, bc);
+        work.resize(dim);
+        r.resize(dim);
+    }
+
+    // b += coef * F + bc,      .
+    void right_part(std::vector<T>& b, T coef, const std::vector<T>& bc)
+    {
+        #pragma omp parallel for
+        for (int i = 0; i < dim; i++)
+            b[i] += coef * F[i] + bc[i];
+        if (fixed_left)
+            b[0] = bc[0];
+        if (fixed_right)
+            b[dim - 1] = bc[dim - 1];
+    }
+
+    void first_bdf2_step(std::vector<T>& q)
+    {
+        BandMatrix<T> A;
+        std::vector<T> bc;
+        system(1, A, bc);
+        A.factorization();
+
+        history = q;
+        M.multiply(q, r);
+        right_part(r, dt, bc);
+        A.solve(q, r);
+    }
+};
+
+template<typename T>
+struct TransientOptions
+{
+    time_scheme scheme = scheme_crank_nicolson;
+    T dt = T(0.01);
+    int steps = 100;
+    //   du/dt   ,   -  
+    std::vector<T> sigma;
+    //    (  -  )      .
+    //  -   dim  ,   T .
+    std::string snapshots;
+    int snapshot_every = 1;
+};
+
+//       q   steps * dt,
+// q -     (  - ),   -   .
+//       ,    :
+//  ,     ,     snapshot_every .
+template<typename T>
+void solve_transient(grid_in& in, IInputFunctions<T>& Functions, std::vector<T>& q,
+    const TransientOptions<T>& options = TransientOptions<T>())
+{
+    TransientProblem<T> problem(in, Functions, options.scheme, options.sigma);
+    int dim = problem.size();
+    if (q.empty())
+        q.assign(dim, 0);
+    problem.set_step(options.dt);
+
+    std::ofstream file;
+    if (!options.snapshots.empty())
+    {
+        file.open(options.snapshots, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            throw new std::invalid_argument("Can not open snapshots file");
+    }
+
+    std::vector<T> buffers[2];
+    std::future<void> writing;
+    int current = 0;
+    auto snapshot = [&](int step)
+    {
+        if (!file.is_open())
+            return;
+        //  current :       
+        std::vector<T>& buffer = buffers[current];
+        buffer.resize(dim + 1);
+        buffer[0] = step * options.dt;
+        std::copy(q.begin(), q.end(), buffer.begin() + 1);
+
+        if (writing.valid())
+            writing.get();
+        writing = std::async(std::launch::async, [&file, &buffer]()
+        {
+            file.write((const char*)buffer.data(), (std::streamsize)buffer.size() * sizeof(T));
+            if (!file)
+                throw new std::runtime_error("Can not write snapshots file");
+        });
+        current = 1 - current;
+    };
+
+    int every = options.snapshot_every < 1 ? 1 : options.snapshot_every;
+    snapshot(0);
+    for (int step = 1; step <= options.steps; step++)
+    {
+        problem.advance(q);
+        if (step % every == 0 || step == options.steps)
+            snapshot(step);
+    }
+
+    if (writing.valid())
+        writing.get();
+}